@@ -30,6 +30,7 @@
 #include "wsFX.h"
 #include "espDMX_RDM.h"
 #include "espArtNetRDM.h"
+#include "dmxPatch.h"
 
 #include <WiFi.h>
 #include <WiFiClient.h>
@@ -52,7 +53,7 @@
 
 #include <rom/rtc.h>
 
-#define CONFIG_VERSION "400"
+#define CONFIG_VERSION "405"
 #define FIRMWARE_VERSION "4.0.0"
 #define ART_FIRM_VERSION 0x0400   // Firmware given over Artnet (2 uint8_ts)
 
@@ -122,7 +123,12 @@ static File fsUploadFile;
 static pixPatterns pixFXA(0, &pixDriver);
 static pixPatterns pixFXB(1, &pixDriver);
 
-static const char PROGMEM mainPage[] = "<!DOCTYPE html><meta content='text/html; charset=utf-8' http-equiv=Content-Type /><title>ESP32 ArtNetNode Config</title><meta content='Matthew Tong - http://github.com/mtongnz/' name=DC.creator /><meta content=en name=DC.language /><meta content='width=device-width,initial-scale=1' name=viewport /><link href=style.css rel=stylesheet /><div id=page><div class=inner><div class=mast><div class=title>ESP32<h1>ArtNet & sACN</h1>to<h1>DMX & LED Pixels</h1></div><ul class=nav><li class=first><a href='javascript: menuClick(1)'>Device Status</a><li><a href='javascript: menuClick(2)'>Network</a><li><a href='javascript: menuClick(3)'>IP & Name</a><li><a href='javascript: menuClick(4)'>Port A</a><li><a href='javascript: menuClick(5)'>Port B</a><li><a href='javascript: menuClick(6)'>Scenes</a><li><a href='javascript: menuClick(7)'>Firmware</a><li class=last><a href='javascript: reboot()'>Reboot</a></ul><div class=author><i>Design by</i> Matthew Tong</div></div><div class='main section'><div class=hide name=error><h2>Error</h2><p class=center>There was an error communicating with the device. Refresh the page and try again.</div><div class=show name=sections><h2>Fetching Data</h2><p class=center>Fetching data from device. If this message is still here in 15 seconds, try refreshing the page or clicking the menu option again.</div><div class=hide name=sections><h2>Device Status</h2><p class=left>Device Name:<p class=right name=nodeName><p class=left>MAC Address:<p class=right name=macAddress><p class=left>Network Status:<p class=right name=wifiStatus><p class=left>IP Address:<p class=right name=ipAddressT><p class=left>Subnet Address:<p class=right name=subAddressT><p class=left>Port A:<p class=right name=portAStatus><p class=left>Port A LED type:<p class=right name=portApixConfig><p class=left>Port B:<p class=right name=portBStatus><p class=left>Port B LED type:<p class=right name=portBpixConfig><p class=left>Scene Storage:<p class=right name=sceneStatus><p class=left>Firmware:<p class=right name=firmwareStatus></div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>Network Settings</h2><p class=left>MAC Address:<p class=right name=macAddress><p class=spacer><p class=left>Wifi SSID:<p class=right><input type=text name=wifiSSID /><p class=left>Password:<p class=right><input type=text name=wifiPass /><p class=spacer><p class=left>Hotspot SSID:<p class=right><input type='text' name='hotspotSSID' /><p class=left>Password:<p class=right><input type=text name=hotspotPass /><p class=left>Start Delay:<p class=right><input name=hotspotDelay type=number min=0 max=180 class=number /> (seconds)<p class=spacer><p class=left>Stand Alone:<p class=right><input name=standAloneEnable type=checkbox value=true /><p class=left>Ethernet:<p class=right><input name=ethernetEnable type=checkbox value=true /><p class=right>In normal mode, the hotspot will start after <i>delay</i> seconds if the main WiFi won't connect. If no users connect, the device will reset and attempt the main WiFi again. This feature is purely for changing settings and ArtNet data is ignored.<p class=right>Stand alone mode disables the primary WiFi connection and allows ArtNet data to be received via the hotspot connection.</div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>IP & Node Name</h2><p class='left'>Short Name:</p><p class=right><input type=text name=nodeName /><p class=left>Long Name:<p class=right><input type=text name=longName /><p class=spacer><p class=left>Enable DHCP:<p class=right><input name=dhcpEnable type=checkbox value=true /><p class=left>IP Address:<p class=right><input name=ipAddress type=number min=0 max=255 class=number /> <input name=ipAddress type=number min=0 max=255 class=number /> <input name=ipAddress type=number min=0 max=255 class=number /> <input name=ipAddress type=number min=0 max=255 class=number /><p class=left>Subnet Address:<p class=right><input name=subAddress type=number min=0 max=255 class=number /> <input name=subAddress type=number min=0 max=255 class=number /> <input name=subAddress type=number min=0 max=255 class=number /> <input name=subAddress type=number min=0 max=255 class=number /><p class=left>Gateway Address:<p class=right><input name=gwAddress type=number min=0 max=255 class=number /> <input name=gwAddress type=number min=0 max=255 class=number /> <input name=gwAddress type=number min=0 max=255 class=number /> <input name=gwAddress type=number min=0 max=255 class=number /><p class=left>Broadcast Address:<p class=right name=bcAddress><p class=center>These settings only affect the main WiFi connection. The hotspot will always have DHCP enabled and an IP of <b>2.0.0.1</b></div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>Port A Settings</h2><p class=left>Port Type:<p class=right><select class=select name=portAmode><option value=0>DMX Output<option value=1>DMX Output with RDM<option value=2>DMX Input<option value=3>LED Pixels - WS2812</select><p class=left>Protocol:<p class=right><select class=select name=portAprot><option value=0>Artnet v4<option value=1>Artnet v4 with sACN DMX</select><p class=left>Merge Mode:<p class=right><select class=select name=portAmerge><option value=0>Merge LTP<option value=1>Merge HTP</select><p class=left>LED Type:<p class=right><select class=select name=portApixConfig><option value=0>WS2812 RGB<option value=1>WS2812 RGBW<option value=2>WS2812 RGBW Split W<option value=3>APA102 RGBB</select><p class=left>Net:<p class=right><input name=portAnet type=number min=0 max=127 class=number /><p class=left>Subnet:<p class=right><input name=portAsub type=number min=0 max=15 class=number /><p class=left>Universe:<p class=right><input type=number min=0 max=15 name=portAuni class=number /><span name=portApix> <input type=number min=0 max=15 name=portAuni class=number /> <input type=number min=0 max=15 name=portAuni class=number /> <input type=number min=0 max=15 name=portAuni class=number /></span></p><p class=left>sACN Universe:<p class=right><input type=number min=0 max=63999 name=portAsACNuni class=number /> <input type=number min=1 max=63999 name=portAsACNuni class=number /> <input type=number min=1 max=63999 name=portAsACNuni class=number /> <input type=number min=1 max=63999 name=portAsACNuni class=number /></p><span name=DmxInBcAddrA><p class=left>Broadcast Address:<p class=right><input type=number min=0 max=255 name=dmxInBroadcast class=number /> <input type=number min=0 max=255 name=dmxInBroadcast class=number /> <input type=number min=0 max=255 name=dmxInBroadcast class=number /> <input type=number min=0 max=255 name=dmxInBroadcast class=number /></p></span><span name=portApix><p class=left>Number of Pixels:<p class=right><input type=number min=0 max=512 name=portAnumPix class=number /> 512 max - 128 per universe</p><p class=left>Mode:</p><p class=right><select class=select name=portApixMode><option value=0>Pixel Mapping</option><option value=1>12 Channel FX</option></select><p class=left>Start Channel:</p><p class=right><input type=number name=portApixFXstart class=number min=1 max=501 /> FX modes only</p></span></div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>Port B Settings</h2><p class=left>Port Type:<p class=right><select class=select name=portBmode><option value=0>DMX Output<option value=1>DMX Output with RDM<option value=3>LED Pixels - WS2812</select><p class=left>Protocol:<p class=right><select class=select name=portBprot><option value=0>Artnet v4<option value=1>Artnet v4 with sACN DMX</select><p class=left>Merge Mode:<p class=right><select class=select name=portBmerge><option value=0>Merge LTP<option value=1>Merge HTP</select><p class=left>LED Type:<p class=right><select class=select name=portBpixConfig><option value=0>WS2812 RGB<option value=1>WS2812 RGBW<option value=2>WS2812 RGBW Split W<option value=3>APA102 RGBB</select><p class=left>Net:<p class=right><input name=portBnet type=number min=0 max=127 class=number /><p class=left>Subnet:<p class=right><input name=portBsub type=number min=0 max=15 class=number /><p class=left>Universe:<p class=right><input type=number min=0 max=15 name=portBuni class=number /><span name=portBpix> <input type=number min=0 max=15 name=portBuni class=number /> <input type=number min=0 max=15 name=portBuni class=number /> <input type=number min=0 max=15 name=portBuni class=number /></span></p><p class=left>sACN Universe:<p class=right><input type=number min=1 max=63999 name=portBsACNuni class=number /> <input type=number min=1 max=63999 name=portBsACNuni class=number /> <input type=number min=1 max=63999 name=portBsACNuni class=number /> <input type=number min=1 max=63999 name=portBsACNuni class=number /></p><span name=portBpix><p class=left>Number of Pixels:<p class=right><input type=number min=0 max=512 name=portBnumPix class=number /> 512 max - 170 per universe</p><p class=left>Mode:</p><p class=right><select class=select name=portBpixMode><option value=0>Pixel Mapping</option><option value=1>12 Channel FX</option></select><p class=left>Start Channel:</p><p class=right><input type=number name=portBpixFXstart class=number min=1 max=501 /> FX modes only</p></span></div><div class=hide name=sections><h2>Stored Scenes</h2><p class=center>Not yet implemented</div><div class=hide name=sections><form action=/update enctype=multipart/form-data method=POST id=firmForm><h2>Update Firmware</h2><p class=left>Firmware:<p class=right name=firmwareStatus><p class=right><input name=update type=file id=update><label for=update><svg height=17 viewBox='0 0 20 17' width=20 xmlns=http://www.w3.org/2000/svg><path d='M10 0l-5.2 4.9h3.3v5.1h3.8v-5.1h3.3l-5.2-4.9zm9.3 11.5l-3.2-2.1h-2l3.4 2.6h-3.5c-.1 0-.2.1-.2.1l-.8 2.3h-6l-.8-2.2c-.1-.1-.1-.2-.2-.2h-3.6l3.4-2.6h-2l-3.2 2.1c-.4.3-.7 1-.6 1.5l.6 3.1c.1.5.7.9 1.2.9h16.3c.6 0 1.1-.4 1.3-.9l.6-3.1c.1-.5-.2-1.2-.7-1.5z'/></svg> <span>Choose Firmware</span></label><p class=right id=uploadMsg></p><p class=right><input type=button class=submit value='Upload Now' id=fUp></div></div><div class=footer><p>Coding and hardware © 2016-2017 <a href=http://github.com/mtongnz/ >Matthew Tong</a>.<p>Released under <a href=http://www.gnu.org/licenses/ >GNU General Public License V3</a>.</div></div></div><script>var cl=0;var num=0;var err=0;var o=document.getElementsByName('sections');var s=document.getElementsByName('save');for (var i=0, e; e=s[i++];)e.addEventListener( 'click', function(){sendData();}); var u=document.getElementById('fUp');var um=document.getElementById('uploadMsg');var fileSelect=document.getElementById('update');u.addEventListener('click',function(){uploadPrep()});function uploadPrep(){if(fileSelect.files.length===0) return;u.disabled=!0;u.value='Preparing Device…';var x=new XMLHttpRequest();x.onreadystatechange=function(){if(x.readyState==XMLHttpRequest.DONE){try{var r=JSON.parse(x.response)}catch(e){var r={success:0,doUpdate:1}} if(r.success==1&&r.doUpdate==1){uploadWait()}else{um.value='<b>Update failed!</b>';u.value='Upload Now';u.disabled=!1}}};x.open('POST','/ajax',!0);x.setRequestHeader('Content-Type','application/json');x.send('{\"doUpdate\":1,\"success\":1}')} function uploadWait(){setTimeout(function(){var z=new XMLHttpRequest();z.onreadystatechange=function(){if(z.readyState==XMLHttpRequest.DONE){try{var r=JSON.parse(z.response)}catch(e){var r={success:0}} console.log('r=' + r.success); if(r.success==1){upload()}else{uploadWait()}}};z.open('POST','/ajax',!0);z.setRequestHeader('Content-Type','application/json');z.send('{\"doUpdate\":2,\"success\":1}')},1000)} var upload=function(){u.value='Uploading… 0%';var data=new FormData();data.append('update',fileSelect.files[0]);var x=new XMLHttpRequest();x.onreadystatechange=function(){if(x.readyState==4){try{var r=JSON.parse(x.response)}catch(e){var r={success:0,message:'No response from device.'}} console.log(r.success+': '+r.message);if(r.success==1){u.value=r.message;setTimeout(function(){location.reload()},15000)}else{um.value='<b>Update failed!</b> '+r.message;u.value='Upload Now';u.disabled=!1}}};x.upload.addEventListener('progress',function(e){var p=Math.ceil((e.loaded/e.total)*100);console.log('Progress: '+p+'%');if(p<100) u.value='Uploading... '+p+'%';else u.value='Upload complete. Processing…'},!1);x.open('POST','/upload',!0);x.send(data)}; function reboot() { if (err == 1) return; var r = confirm('Are you sure you want to reboot?'); if (r != true) return; o[cl].className = 'hide'; o[0].childNodes[0].innerHTML = 'Rebooting'; o[0].childNodes[1].innerHTML = 'Please wait while the device reboots. This page will refresh shortly unless you changed the IP or Wifi.'; o[0].className = 'show'; err = 0; var x = new XMLHttpRequest(); x.onreadystatechange = function(){ if(x.readyState == 4){ try { var r = JSON.parse(x.response); } catch (e){ var r = {success: 0, message: 'Unknown error: [' + x.responseText + ']'}; } if (r.success != 1) { o[0].childNodes[0].innerHTML = 'Reboot Failed'; o[0].childNodes[1].innerHTML = 'Something went wrong and the device didn\\'t respond correctly. Please try again.'; } setTimeout(function() { location.reload(); }, 5000); } }; x.open('POST', '/ajax', true); x.setRequestHeader('Content-Type', 'application/json'); x.send('{\"reboot\":1,\"success\":1}'); } function sendData(){var d={'page':num};for (var i=0, e; e=o[cl].getElementsByTagName('INPUT')[i++];){var k=e.getAttribute('name');var v=e.value;if (k in d) continue; if (k=='ipAddress' || k=='subAddress' || k=='gwAddress' || k=='portAuni' || k=='portBuni' || k=='portAsACNuni' || k=='portBsACNuni' || k=='dmxInBroadcast'){var c=[v];for (var z=1; z < 4; z++){c.push(o[cl].getElementsByTagName('INPUT')[i++].value);}d[k]=c; continue;}if (e.type==='text')d[k]=v;if (e.type==='number'){if (v=='')v=0;d[k]=v;}if (e.type==='checkbox'){if (e.checked)d[k]=1;else d[k]=0;}}for (var i=0, e; e=o[cl].getElementsByTagName('SELECT')[i++];){d[e.getAttribute('name')]=e.options[e.selectedIndex].value;}d['success']=1;var x=new XMLHttpRequest();x.onreadystatechange=function(){handleAJAX(x);};x.open('POST', '/ajax');x.setRequestHeader('Content-Type', 'application/json');x.send(JSON.stringify(d));console.log(d);} function menuClick(n){if (err==1) return; num=n; setTimeout(function(){if (cl==num || err==1) return; o[cl].className='hide'; o[0].className='show'; cl=0;}, 100); var x=new XMLHttpRequest(); x.onreadystatechange=function(){handleAJAX(x);}; x.open('POST', '/ajax'); x.setRequestHeader('Content-Type', 'application/json'); x.send(JSON.stringify({\"page\":num,\"success\":1}));}function handleAJAX(x){if (x.readyState==XMLHttpRequest.DONE ){if (x.status==200){var response=JSON.parse(x.responseText);console.log(response);if (!response.hasOwnProperty('success')){err=1; o[cl].className='hide'; document.getElementsByName('error')[0].className='show';return;}if (response['success'] !=1){err=1; o[cl].className='hide';document.getElementsByName('error')[0].getElementsByTagName('P')[0].innerHTML=response['message']; document.getElementsByName('error')[0].className='show';return;}if (response.hasOwnProperty('message')) { for (var i = 0, e; e = s[i++];) { e.value = response['message']; e.className = 'showMessage' } setTimeout(function() { for (var i = 0, e; e = s[i++];) { e.value = 'Save Changes'; e.className = '' } }, 5000); } o[cl].className='hide'; o[num].className='show'; cl=num; for (var key in response){if (response.hasOwnProperty(key)){var a=document.getElementsByName(key); if (key=='ipAddress' || key=='subAddress'){var b=document.getElementsByName(key + 'T'); for (var z=0; z < 4; z++){a[z].value=response[key][z]; if (z==0) b[0].innerHTML=''; else b[0].innerHTML=b[0].innerHTML + ' . '; b[0].innerHTML=b[0].innerHTML + response[key][z];}continue;}else if (key=='bcAddress'){for (var z=0; z < 4; z++){if (z==0) a[0].innerHTML=''; else a[0].innerHTML=a[0].innerHTML + ' . '; a[0].innerHTML=a[0].innerHTML + response[key][z];}continue;} else if (key=='gwAddress' || key=='dmxInBroadcast' || key=='portAuni' || key=='portBuni' || key=='portAsACNuni' || key=='portBsACNuni'){for(var z=0;z<4;z++){a[z].value = response[key][z];}continue}if(key=='portAmode'){var b = document.getElementsByName('portApix');var c = document.getElementsByName('DmxInBcAddrA');if(response[key] == 3) {b[0].style.display = '';b[1].style.display = '';} else {b[0].style.display = 'none';b[1].style.display = 'none';}if (response[key] == 2){c[0].style.display = '';}else{c[0].style.display = 'none';}} else if (key == 'portBmode') {var b = document.getElementsByName('portBpix');if(response[key] == 3) {b[0].style.display = '';b[1].style.display = '';} else {b[0].style.display = 'none';b[1].style.display = 'none';}}for (var z=0; z < a.length; z++){switch (a[z].nodeName){case 'P': case 'DIV': a[z].innerHTML=response[key]; break; case 'INPUT': if (a[z].type=='checkbox'){if (response[key]==1) a[z].checked=true; else a[z].checked=false;}else a[z].value=response[key]; break; case 'SELECT': for (var y=0; y < a[z].options.length; y++){if (a[z].options[y].value==response[key]){a[z].options.selectedIndex=y; break;}}break;}}}}}else{err=1; o[cl].className='hide'; document.getElementsByName('error')[0].className='show';}}}var update=document.getElementById('update');var label=update.nextElementSibling;var labelVal=label.innerHTML;update.addEventListener( 'change', function( e ){var fileName=e.target.value.split( '\\\\' ).pop(); if( fileName ) label.querySelector( 'span' ).innerHTML=fileName; else label.innerHTML=labelVal; update.blur();}); document.onkeydown=function(e){if(cl < 2 || cl > 6)return; var e = e||window.event; if (e.keyCode == 13)sendData();}; menuClick(1);</script></body></html>";
+// Channel patches for each output port + which need applying again
+static dmxPatch patchA;
+static dmxPatch patchB;
+static uint8_t patchDirty = 0;
+
+static const char PROGMEM mainPage[] = "<!DOCTYPE html><meta content='text/html; charset=utf-8' http-equiv=Content-Type /><title>ESP32 ArtNetNode Config</title><meta content='Matthew Tong - http://github.com/mtongnz/' name=DC.creator /><meta content=en name=DC.language /><meta content='width=device-width,initial-scale=1' name=viewport /><link href=style.css rel=stylesheet /><div id=page><div class=inner><div class=mast><div class=title>ESP32<h1>ArtNet & sACN</h1>to<h1>DMX & LED Pixels</h1></div><ul class=nav><li class=first><a href='javascript: menuClick(1)'>Device Status</a><li><a href='javascript: menuClick(2)'>Network</a><li><a href='javascript: menuClick(3)'>IP & Name</a><li><a href='javascript: menuClick(4)'>Port A</a><li><a href='javascript: menuClick(5)'>Port B</a><li><a href='javascript: menuClick(6)'>Scenes</a><li><a href='javascript: menuClick(7)'>Firmware</a><li class=last><a href='javascript: reboot()'>Reboot</a></ul><div class=author><i>Design by</i> Matthew Tong</div></div><div class='main section'><div class=hide name=error><h2>Error</h2><p class=center>There was an error communicating with the device. Refresh the page and try again.</div><div class=show name=sections><h2>Fetching Data</h2><p class=center>Fetching data from device. If this message is still here in 15 seconds, try refreshing the page or clicking the menu option again.</div><div class=hide name=sections><h2>Device Status</h2><p class=left>Device Name:<p class=right name=nodeName><p class=left>MAC Address:<p class=right name=macAddress><p class=left>Network Status:<p class=right name=wifiStatus><p class=left>IP Address:<p class=right name=ipAddressT><p class=left>Subnet Address:<p class=right name=subAddressT><p class=left>Port A:<p class=right name=portAStatus><p class=left>Port A LED type:<p class=right name=portApixConfig><p class=left>Port A output:<p class=right name=portAoutput><p class=left>Port B:<p class=right name=portBStatus><p class=left>Port B LED type:<p class=right name=portBpixConfig><p class=left>Port B output:<p class=right name=portBoutput><p class=left>Scene Storage:<p class=right name=sceneStatus><p class=left>Firmware:<p class=right name=firmwareStatus></div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>Network Settings</h2><p class=left>MAC Address:<p class=right name=macAddress><p class=spacer><p class=left>Wifi SSID:<p class=right><input type=text name=wifiSSID /><p class=left>Password:<p class=right><input type=text name=wifiPass /><p class=spacer><p class=left>Hotspot SSID:<p class=right><input type='text' name='hotspotSSID' /><p class=left>Password:<p class=right><input type=text name=hotspotPass /><p class=left>Start Delay:<p class=right><input name=hotspotDelay type=number min=0 max=180 class=number /> (seconds)<p class=spacer><p class=left>Stand Alone:<p class=right><input name=standAloneEnable type=checkbox value=true /><p class=left>Ethernet:<p class=right><input name=ethernetEnable type=checkbox value=true /><p class=right>In normal mode, the hotspot will start after <i>delay</i> seconds if the main WiFi won't connect. If no users connect, the device will reset and attempt the main WiFi again. This feature is purely for changing settings and ArtNet data is ignored.<p class=right>Stand alone mode disables the primary WiFi connection and allows ArtNet data to be received via the hotspot connection.</div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>IP & Node Name</h2><p class='left'>Short Name:</p><p class=right><input type=text name=nodeName /><p class=left>Long Name:<p class=right><input type=text name=longName /><p class=spacer><p class=left>Enable DHCP:<p class=right><input name=dhcpEnable type=checkbox value=true /><p class=left>IP Address:<p class=right><input name=ipAddress type=number min=0 max=255 class=number /> <input name=ipAddress type=number min=0 max=255 class=number /> <input name=ipAddress type=number min=0 max=255 class=number /> <input name=ipAddress type=number min=0 max=255 class=number /><p class=left>Subnet Address:<p class=right><input name=subAddress type=number min=0 max=255 class=number /> <input name=subAddress type=number min=0 max=255 class=number /> <input name=subAddress type=number min=0 max=255 class=number /> <input name=subAddress type=number min=0 max=255 class=number /><p class=left>Gateway Address:<p class=right><input name=gwAddress type=number min=0 max=255 class=number /> <input name=gwAddress type=number min=0 max=255 class=number /> <input name=gwAddress type=number min=0 max=255 class=number /> <input name=gwAddress type=number min=0 max=255 class=number /><p class=left>Broadcast Address:<p class=right name=bcAddress><p class=center>These settings only affect the main WiFi connection. The hotspot will always have DHCP enabled and an IP of <b>2.0.0.1</b></div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>Port A Settings</h2><p class=left>Port Type:<p class=right><select class=select name=portAmode><option value=0>DMX Output<option value=1>DMX Output with RDM<option value=2>DMX Input<option value=3>LED Pixels - WS2812</select><p class=left>Protocol:<p class=right><select class=select name=portAprot><option value=0>Artnet v4<option value=1>Artnet v4 with sACN DMX<option value=2>Artnet v4 with sACN DMX - sACN wins<option value=3>Artnet v4 with sACN DMX - Artnet wins</select><p class=left>Merge Mode:<p class=right><select class=select name=portAmerge><option value=0>Merge LTP<option value=1>Merge HTP<option value=2>Merge HTP by Priority</select><p class=left>DMX Timing:<p class=right><select class=select name=portAtiming><option value=0>Standard<option value=1>Turbo - spec minimum, up to 830Hz<option value=2>Safe - long breaks for slow fixtures</select><p class=left>Source Loss:<p class=right><select class=select name=portAloss><option value=0>Hold last look<option value=1>Hold then fade to black<option value=2>Hold then fade to stored look</select><p class=left>Loss Hold:<p class=right><input name=portAlossHold type=number min=0 max=255 class=number /> seconds<p class=left>Loss Fade:<p class=right><input name=portAlossFade type=number min=0 max=255 class=number /> tenths of a second<p class=left>Sources:<p class=right><input name=portAsources type=number min=1 max=8 class=number /> merged at once - more are ignored until one times out<p class=left>Source Timeout:<p class=right><input name=portAsourceTimeout type=number min=1 max=255 class=number /> seconds<p class=left>Patch:<p class=right><input type=text name=portApatch /> input:slot&gt;slot*count, blank for 1:1<p class=left>Curves:<p class=right><input type=text name=portAcurves /> first-last:curve - square, scurve, root or invert<p class=left>LED Type:<p class=right><select class=select name=portApixConfig><option value=0>WS2812 RGB<option value=1>WS2812 RGBW<option value=2>WS2812 RGBW Split W<option value=3>APA102 RGBB</select><p class=left>Net:<p class=right><input name=portAnet type=number min=0 max=127 class=number /><p class=left>Subnet:<p class=right><input name=portAsub type=number min=0 max=15 class=number /><p class=left>Universe:<p class=right><input type=number min=0 max=15 name=portAuni class=number /><span name=portApix> <input type=number min=0 max=15 name=portAuni class=number /> <input type=number min=0 max=15 name=portAuni class=number /> <input type=number min=0 max=15 name=portAuni class=number /></span></p><p class=left>sACN Universe:<p class=right><input type=number min=0 max=63999 name=portAsACNuni class=number /> <input type=number min=1 max=63999 name=portAsACNuni class=number /> <input type=number min=1 max=63999 name=portAsACNuni class=number /> <input type=number min=1 max=63999 name=portAsACNuni class=number /></p><span name=DmxInBcAddrA><p class=left>Broadcast Address:<p class=right><input type=number min=0 max=255 name=dmxInBroadcast class=number /> <input type=number min=0 max=255 name=dmxInBroadcast class=number /> <input type=number min=0 max=255 name=dmxInBroadcast class=number /> <input type=number min=0 max=255 name=dmxInBroadcast class=number /></p><p class=left>Send Rate:<p class=right><input type=number min=0 max=255 name=dmxInRate class=number /> most per second when slots change, 0 for no limit<p class=left>Keepalive:<p class=right><input type=number min=0 max=255 name=dmxInKeepAlive class=number /> tenths of a second<p class=left>Local Output:<p class=right><input name=dmxInLocal type=checkbox value=true /> also to this node's ports on the same universe</span><span name=portApix><p class=left>Number of Pixels:<p class=right><input type=number min=0 max=512 name=portAnumPix class=number /> 512 max - 128 per universe</p><p class=left>Mode:</p><p class=right><select class=select name=portApixMode><option value=0>Pixel Mapping</option><option value=1>12 Channel FX</option></select><p class=left>Start Channel:</p><p class=right><input type=number name=portApixFXstart class=number min=1 max=501 /> FX modes only</p></span></div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>Port B Settings</h2><p class=left>Port Type:<p class=right><select class=select name=portBmode><option value=0>DMX Output<option value=1>DMX Output with RDM<option value=3>LED Pixels - WS2812</select><p class=left>Protocol:<p class=right><select class=select name=portBprot><option value=0>Artnet v4<option value=1>Artnet v4 with sACN DMX<option value=2>Artnet v4 with sACN DMX - sACN wins<option value=3>Artnet v4 with sACN DMX - Artnet wins</select><p class=left>Merge Mode:<p class=right><select class=select name=portBmerge><option value=0>Merge LTP<option value=1>Merge HTP<option value=2>Merge HTP by Priority</select><p class=left>DMX Timing:<p class=right><select class=select name=portBtiming><option value=0>Standard<option value=1>Turbo - spec minimum, up to 830Hz<option value=2>Safe - long breaks for slow fixtures</select><p class=left>Source Loss:<p class=right><select class=select name=portBloss><option value=0>Hold last look<option value=1>Hold then fade to black<option value=2>Hold then fade to stored look</select><p class=left>Loss Hold:<p class=right><input name=portBlossHold type=number min=0 max=255 class=number /> seconds<p class=left>Loss Fade:<p class=right><input name=portBlossFade type=number min=0 max=255 class=number /> tenths of a second<p class=left>Sources:<p class=right><input name=portBsources type=number min=1 max=8 class=number /> merged at once - more are ignored until one times out<p class=left>Source Timeout:<p class=right><input name=portBsourceTimeout type=number min=1 max=255 class=number /> seconds<p class=left>Patch:<p class=right><input type=text name=portBpatch /> input:slot&gt;slot*count, blank for 1:1<p class=left>Curves:<p class=right><input type=text name=portBcurves /> first-last:curve - square, scurve, root or invert<p class=left>LED Type:<p class=right><select class=select name=portBpixConfig><option value=0>WS2812 RGB<option value=1>WS2812 RGBW<option value=2>WS2812 RGBW Split W<option value=3>APA102 RGBB</select><p class=left>Net:<p class=right><input name=portBnet type=number min=0 max=127 class=number /><p class=left>Subnet:<p class=right><input name=portBsub type=number min=0 max=15 class=number /><p class=left>Universe:<p class=right><input type=number min=0 max=15 name=portBuni class=number /><span name=portBpix> <input type=number min=0 max=15 name=portBuni class=number /> <input type=number min=0 max=15 name=portBuni class=number /> <input type=number min=0 max=15 name=portBuni class=number /></span></p><p class=left>sACN Universe:<p class=right><input type=number min=1 max=63999 name=portBsACNuni class=number /> <input type=number min=1 max=63999 name=portBsACNuni class=number /> <input type=number min=1 max=63999 name=portBsACNuni class=number /> <input type=number min=1 max=63999 name=portBsACNuni class=number /></p><span name=portBpix><p class=left>Number of Pixels:<p class=right><input type=number min=0 max=512 name=portBnumPix class=number /> 512 max - 170 per universe</p><p class=left>Mode:</p><p class=right><select class=select name=portBpixMode><option value=0>Pixel Mapping</option><option value=1>12 Channel FX</option></select><p class=left>Start Channel:</p><p class=right><input type=number name=portBpixFXstart class=number min=1 max=501 /> FX modes only</p></span></div><div class=hide name=sections><input name=save type=button value='Save Changes'/><h2>Stored Scenes</h2><p class=left>Source Loss Look:<p class=right><select class=select name=lossLookStore><option value=0>Keep stored looks<option value=1>Store current outputs</select></div><div class=hide name=sections><form action=/update enctype=multipart/form-data method=POST id=firmForm><h2>Update Firmware</h2><p class=left>Firmware:<p class=right name=firmwareStatus><p class=right><input name=update type=file id=update><label for=update><svg height=17 viewBox='0 0 20 17' width=20 xmlns=http://www.w3.org/2000/svg><path d='M10 0l-5.2 4.9h3.3v5.1h3.8v-5.1h3.3l-5.2-4.9zm9.3 11.5l-3.2-2.1h-2l3.4 2.6h-3.5c-.1 0-.2.1-.2.1l-.8 2.3h-6l-.8-2.2c-.1-.1-.1-.2-.2-.2h-3.6l3.4-2.6h-2l-3.2 2.1c-.4.3-.7 1-.6 1.5l.6 3.1c.1.5.7.9 1.2.9h16.3c.6 0 1.1-.4 1.3-.9l.6-3.1c.1-.5-.2-1.2-.7-1.5z'/></svg> <span>Choose Firmware</span></label><p class=right id=uploadMsg></p><p class=right><input type=button class=submit value='Upload Now' id=fUp></div></div><div class=footer><p>Coding and hardware © 2016-2017 <a href=http://github.com/mtongnz/ >Matthew Tong</a>.<p>Released under <a href=http://www.gnu.org/licenses/ >GNU General Public License V3</a>.</div></div></div><script>var cl=0;var num=0;var err=0;var o=document.getElementsByName('sections');var s=document.getElementsByName('save');for (var i=0, e; e=s[i++];)e.addEventListener( 'click', function(){sendData();}); var u=document.getElementById('fUp');var um=document.getElementById('uploadMsg');var fileSelect=document.getElementById('update');u.addEventListener('click',function(){uploadPrep()});function uploadPrep(){if(fileSelect.files.length===0) return;u.disabled=!0;u.value='Preparing Device…';var x=new XMLHttpRequest();x.onreadystatechange=function(){if(x.readyState==XMLHttpRequest.DONE){try{var r=JSON.parse(x.response)}catch(e){var r={success:0,doUpdate:1}} if(r.success==1&&r.doUpdate==1){uploadWait()}else{um.value='<b>Update failed!</b>';u.value='Upload Now';u.disabled=!1}}};x.open('POST','/ajax',!0);x.setRequestHeader('Content-Type','application/json');x.send('{\"doUpdate\":1,\"success\":1}')} function uploadWait(){setTimeout(function(){var z=new XMLHttpRequest();z.onreadystatechange=function(){if(z.readyState==XMLHttpRequest.DONE){try{var r=JSON.parse(z.response)}catch(e){var r={success:0}} console.log('r=' + r.success); if(r.success==1){upload()}else{uploadWait()}}};z.open('POST','/ajax',!0);z.setRequestHeader('Content-Type','application/json');z.send('{\"doUpdate\":2,\"success\":1}')},1000)} var upload=function(){u.value='Uploading… 0%';var data=new FormData();data.append('update',fileSelect.files[0]);var x=new XMLHttpRequest();x.onreadystatechange=function(){if(x.readyState==4){try{var r=JSON.parse(x.response)}catch(e){var r={success:0,message:'No response from device.'}} console.log(r.success+': '+r.message);if(r.success==1){u.value=r.message;setTimeout(function(){location.reload()},15000)}else{um.value='<b>Update failed!</b> '+r.message;u.value='Upload Now';u.disabled=!1}}};x.upload.addEventListener('progress',function(e){var p=Math.ceil((e.loaded/e.total)*100);console.log('Progress: '+p+'%');if(p<100) u.value='Uploading... '+p+'%';else u.value='Upload complete. Processing…'},!1);x.open('POST','/upload',!0);x.send(data)}; function reboot() { if (err == 1) return; var r = confirm('Are you sure you want to reboot?'); if (r != true) return; o[cl].className = 'hide'; o[0].childNodes[0].innerHTML = 'Rebooting'; o[0].childNodes[1].innerHTML = 'Please wait while the device reboots. This page will refresh shortly unless you changed the IP or Wifi.'; o[0].className = 'show'; err = 0; var x = new XMLHttpRequest(); x.onreadystatechange = function(){ if(x.readyState == 4){ try { var r = JSON.parse(x.response); } catch (e){ var r = {success: 0, message: 'Unknown error: [' + x.responseText + ']'}; } if (r.success != 1) { o[0].childNodes[0].innerHTML = 'Reboot Failed'; o[0].childNodes[1].innerHTML = 'Something went wrong and the device didn\\'t respond correctly. Please try again.'; } setTimeout(function() { location.reload(); }, 5000); } }; x.open('POST', '/ajax', true); x.setRequestHeader('Content-Type', 'application/json'); x.send('{\"reboot\":1,\"success\":1}'); } function sendData(){var d={'page':num};for (var i=0, e; e=o[cl].getElementsByTagName('INPUT')[i++];){var k=e.getAttribute('name');var v=e.value;if (k in d) continue; if (k=='ipAddress' || k=='subAddress' || k=='gwAddress' || k=='portAuni' || k=='portBuni' || k=='portAsACNuni' || k=='portBsACNuni' || k=='dmxInBroadcast'){var c=[v];for (var z=1; z < 4; z++){c.push(o[cl].getElementsByTagName('INPUT')[i++].value);}d[k]=c; continue;}if (e.type==='text')d[k]=v;if (e.type==='number'){if (v=='')v=0;d[k]=v;}if (e.type==='checkbox'){if (e.checked)d[k]=1;else d[k]=0;}}for (var i=0, e; e=o[cl].getElementsByTagName('SELECT')[i++];){d[e.getAttribute('name')]=e.options[e.selectedIndex].value;}d['success']=1;var x=new XMLHttpRequest();x.onreadystatechange=function(){handleAJAX(x);};x.open('POST', '/ajax');x.setRequestHeader('Content-Type', 'application/json');x.send(JSON.stringify(d));console.log(d);} function menuClick(n){if (err==1) return; num=n; setTimeout(function(){if (cl==num || err==1) return; o[cl].className='hide'; o[0].className='show'; cl=0;}, 100); var x=new XMLHttpRequest(); x.onreadystatechange=function(){handleAJAX(x);}; x.open('POST', '/ajax'); x.setRequestHeader('Content-Type', 'application/json'); x.send(JSON.stringify({\"page\":num,\"success\":1}));}function handleAJAX(x){if (x.readyState==XMLHttpRequest.DONE ){if (x.status==200){var response=JSON.parse(x.responseText);console.log(response);if (!response.hasOwnProperty('success')){err=1; o[cl].className='hide'; document.getElementsByName('error')[0].className='show';return;}if (response['success'] !=1){err=1; o[cl].className='hide';document.getElementsByName('error')[0].getElementsByTagName('P')[0].innerHTML=response['message']; document.getElementsByName('error')[0].className='show';return;}if (response.hasOwnProperty('message')) { for (var i = 0, e; e = s[i++];) { e.value = response['message']; e.className = 'showMessage' } setTimeout(function() { for (var i = 0, e; e = s[i++];) { e.value = 'Save Changes'; e.className = '' } }, 5000); } o[cl].className='hide'; o[num].className='show'; cl=num; for (var key in response){if (response.hasOwnProperty(key)){var a=document.getElementsByName(key); if (key=='ipAddress' || key=='subAddress'){var b=document.getElementsByName(key + 'T'); for (var z=0; z < 4; z++){a[z].value=response[key][z]; if (z==0) b[0].innerHTML=''; else b[0].innerHTML=b[0].innerHTML + ' . '; b[0].innerHTML=b[0].innerHTML + response[key][z];}continue;}else if (key=='bcAddress'){for (var z=0; z < 4; z++){if (z==0) a[0].innerHTML=''; else a[0].innerHTML=a[0].innerHTML + ' . '; a[0].innerHTML=a[0].innerHTML + response[key][z];}continue;} else if (key=='gwAddress' || key=='dmxInBroadcast' || key=='portAuni' || key=='portBuni' || key=='portAsACNuni' || key=='portBsACNuni'){for(var z=0;z<4;z++){a[z].value = response[key][z];}continue}if(key=='portAmode'){var b = document.getElementsByName('portApix');var c = document.getElementsByName('DmxInBcAddrA');if(response[key] == 3) {b[0].style.display = '';b[1].style.display = '';} else {b[0].style.display = 'none';b[1].style.display = 'none';}if (response[key] == 2){c[0].style.display = '';}else{c[0].style.display = 'none';}} else if (key == 'portBmode') {var b = document.getElementsByName('portBpix');if(response[key] == 3) {b[0].style.display = '';b[1].style.display = '';} else {b[0].style.display = 'none';b[1].style.display = 'none';}}for (var z=0; z < a.length; z++){switch (a[z].nodeName){case 'P': case 'DIV': a[z].innerHTML=response[key]; break; case 'INPUT': if (a[z].type=='checkbox'){if (response[key]==1) a[z].checked=true; else a[z].checked=false;}else a[z].value=response[key]; break; case 'SELECT': for (var y=0; y < a[z].options.length; y++){if (a[z].options[y].value==response[key]){a[z].options.selectedIndex=y; break;}}break;}}}}}else{err=1; o[cl].className='hide'; document.getElementsByName('error')[0].className='show';}}}var update=document.getElementById('update');var label=update.nextElementSibling;var labelVal=label.innerHTML;update.addEventListener( 'change', function( e ){var fileName=e.target.value.split( '\\\\' ).pop(); if( fileName ) label.querySelector( 'span' ).innerHTML=fileName; else label.innerHTML=labelVal; update.blur();}); document.onkeydown=function(e){if(cl < 2 || cl > 6)return; var e = e||window.event; if (e.keyCode == 13)sendData();}; menuClick(1);</script></body></html>";
 static const char PROGMEM cssUploadPage[] = "<html><head><title>espArtNetNode CSS Upload</title></head><body>Select and upload your CSS file.  This will overwrite any previous uploads but you can restore the default below.<br /><br /><form method='POST' action='/style_upload' enctype='multipart/form-data'><input type='file' name='css'><input type='submit' value='Upload New CSS'></form><br /><a href='/style_delete'>Restore default CSS</a></body></html>";
 static const char PROGMEM css[] = ".author,.title,ul.nav a{text-align:center}.author i,.show,.title h1,ul.nav a{display:block}input,ul.nav a:hover{background-color:#DADADA}a,abbr,acronym,address,applet,b,big,blockquote,body,caption,center,cite,code,dd,del,dfn,div,dl,dt,em,fieldset,font,form,h1,h2,h3,h4,h5,h6,html,i,iframe,img,ins,kbd,label,legend,li,object,ol,p,pre,q,s,samp,small,span,strike,strong,sub,sup,table,tbody,td,tfoot,th,thead,tr,tt,u,ul,var{margin:0;padding:0;border:0;outline:0;font-size:100%;vertical-align:baseline;background:0 0}.main h2,li.last{border-bottom:1px solid #888583}body{line-height:1;background:#E4E4E4;color:#292929;color:rgba(0,0,0,.82);font:400 100% Cambria,Georgia,serif;-moz-text-shadow:0 1px 0 rgba(255,255,255,.8);}ol,ul{list-style:none}a{color:#890101;text-decoration:none;-moz-transition:.2s color linear;-webkit-transition:.2s color linear;transition:.2s color linear}a:hover{color:#DF3030}#page{padding:0}.inner{margin:0 auto;width:91%}.amp{font-family:Baskerville,Garamond,Palatino,'Palatino Linotype','Hoefler Text','Times New Roman',serif;font-style:italic;font-weight:400}.mast{float:left;width:31.875%}.title{font:semi 700 16px/1.2 Baskerville,Garamond,Palatino,'Palatino Linotype','Hoefler Text','Times New Roman',serif;padding-top:0}.title h1{font:700 20px/1.2 'Book Antiqua','Palatino Linotype',Georgia,serif;padding-top:0}.author{font:400 100% Cambria,Georgia,serif}.author i{font:400 12px Baskerville,Garamond,Palatino,'Palatino Linotype','Hoefler Text','Times New Roman',serif;letter-spacing:.05em;padding-top:.7em}.footer,.main{float:right;width:65.9375%}ul.nav{margin:1em auto 0;width:11em}ul.nav a{font:700 14px/1.2 'Book Antiqua','Palatino Linotype',Georgia,serif;letter-spacing:.1em;padding:.7em .5em;margin-bottom:0;text-transform:uppercase}input[type=button],input[type=button]:focus{background-color:#E4E4E4;color:#890101}li{border-top:1px solid #888583}.hide{display:none}.main h2{font-size:1.4em;text-align:left;margin:0 0 1em;padding:0 0 .3em}.main{position:relative}p.left{clear:left;float:left;width:20%;min-width:120px;max-width:300px;margin:0 0 .6em;padding:0;text-align:right}p.right,select{min-width:200px}p.right{overflow:auto;margin:0 0 .6em .4em;padding-left:.6em;text-align:left}p.center,p.spacer{padding:0;display:block}.footer,p.center{text-align:center}p.center{float:left;clear:both;margin:3em 0 3em 15%;width:70%}p.spacer{float:left;clear:both;margin:0;width:100%;height:20px}input{margin:0;border:0;color:#890101;outline:0;font:400 100% Cambria,Georgia,serif}input[type=text]{width:70%;min-width:200px;padding:0 5px}input[type=number]{min-width:50px;width:50px}input:focus{background-color:silver;color:#000}input[type=checkbox]{-webkit-appearance:none;background-color:#fafafa;border:1px solid #cacece;box-shadow:0 1px 2px rgba(0,0,0,.05),inset 0 -15px 10px -12px rgba(0,0,0,.05);padding:9px;border-radius:5px;display:inline-block;position:relative}input[type=checkbox]:active,input[type=checkbox]:checked:active{box-shadow:0 1px 2px rgba(0,0,0,.05),inset 0 1px 3px rgba(0,0,0,.1)}input[type=checkbox]:checked{background-color:#fafafa;border:1px solid #adb8c0;box-shadow:0 1px 2px rgba(0,0,0,.05),inset 0 -15px 10px -12px rgba(0,0,0,.05),inset 15px 10px -12px rgba(255,255,255,.1);color:#99a1a7}input[type=checkbox]:checked:after{content:'\\2714';font-size:14px;position:absolute;top:0;left:3px;color:#890101}input[type=button],input[type=file]+label{font:700 16px/1.2 'Book Antiqua','Palatino Linotype',Georgia,serif;margin:17px 0 0}input[type=button]{position:absolute;right:0;display:block;border:1px solid #adb8c0;float:right;border-radius:12px;padding:5px 20px 2px 23px;-webkit-transition-duration:.3s;transition-duration:.3s}input[type=button]:hover{background-color:#909090;color:#fff;padding:5px 62px 2px 65px}input.submit{float:left;position: relative}input.showMessage,input.showMessage:focus,input.showMessage:hover{background-color:#6F0;color:#000;padding:5px 62px 2px 65px}input[type=file]{width:.1px;height:.1px;opacity:0;overflow:hidden;position:absolute;z-index:-1}input[type=file]+label{float:left;clear:both;cursor:pointer;border:1px solid #adb8c0;border-radius:12px;padding:5px 20px 2px 23px;display:inline-block;background-color:#E4E4E4;color:#890101;overflow:hidden;-webkit-transition-duration:.3s;transition-duration:.3s}input[type=file]+label:hover,input[type=file]:focus+label{background-color:#909090;color:#fff;padding:5px 40px 2px 43px}input[type=file]+label svg{width:1em;height:1em;vertical-align:middle;fill:currentColor;margin-top:-.25em;margin-right:.25em}select{margin:0;border:0;background-color:#DADADA;color:#890101;outline:0;font:400 100% Cambria,Georgia,serif;width:50%;padding:0 5px}.footer{border-top:1px solid #888583;display:block;font-size:12px;margin-top:20px;padding:.7em 0 20px}.footer p{margin-bottom:.5em}@media (min-width:600px){.inner{min-width:600px}}@media (max-width:600px){.inner,.page{min-width:300px;width:100%;overflow-x:hidden}.footer,.main,.mast{float:left;width:100%}.mast{border-top:1px solid #888583;border-bottom:1px solid #888583}.main{margin-top:4px;width:98%}ul.nav{margin:0 auto;width:100%}ul.nav li{float:left;min-width:100px;width:33%}ul.nav a{font:12px Helvetica,Arial,sans-serif;letter-spacing:0;padding:.8em}.title,.title h1{padding:0;text-align:center}ul.nav a:focus,ul.nav a:hover{background-position:0 100%}.author{display:none}.title{border-bottom:1px solid #888583;width:100%;display:block;font:400 15px Baskerville,Garamond,Palatino,'Palatino Linotype','Hoefler Text','Times New Roman',serif}.title h1{font:600 15px Baskerville,Garamond,Palatino,'Palatino Linotype','Hoefler Text','Times New Roman',serif;display:inline}p.left,p.right{clear:both;float:left;margin-right:1em}li,li.first,li.last{border:0}p.left{width:100%;text-align:left;margin-left:.4em;font-weight:600}p.right{margin-left:1em;width:100%}p.center{margin:1em 0;width:100%}p.spacer{display:none}input[type=text],select{width:85%;}@media (min-width:1300px){.page{width:1300px}}";
 static const char PROGMEM typeHTML[] = "text/html";
@@ -135,15 +141,34 @@ static char nodeError[ARTNET_NODE_REPORT_LENGTH] = "";
 static bool nodeErrorShowing = 1;
 static uint32_t nodeErrorTimeout = 0;
 static bool pixDone = true;
-static bool newDmxIn = false;
+static volatile bool newDmxIn = false;
 static bool doReboot = false;
 static uint8_t* dataIn = 0;
+static volatile uint16_t dataInChans = 512;
+
+// The input callback swaps dataIn from its interrupt, so the main loop works on a copy taken under dataInMux
+static portMUX_TYPE dataInMux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t* dmxInFrame = 0;
+
+// Last DMX input frame sent as Artnet & when
+static uint8_t* dmxInSent = 0;
+static uint32_t dmxInSentTime = 0;
+
+// Looks each Artnet port fades to when it loses its sources, loaded from SPIFFS when first needed
+static uint8_t* lossLook[2][4] = { { 0 } };
 
 static void wifiStart();
 static void webStart();
 static void artStart();
 static void portSetup();
 static void startHotspot();
+static void patchLoad(uint8_t side);
+static void patchOutput();
+static uint16_t dmxInCopy();
+static void dmxInSend();
+static void setPortProtocol(uint8_t group, uint8_t port, uint8_t prot);
+static void setPortLoss(uint8_t side, uint8_t port);
+static void setPortSources(uint8_t side, uint8_t port);
 static void doNodeReport();
 
 enum fx_mode {
@@ -160,12 +185,23 @@ enum p_type {
 
 enum p_protocol {
   PROT_ARTNET = 0,
-  PROT_ARTNET_SACN = 1
+  PROT_ARTNET_SACN = 1,
+  PROT_ARTNET_SACN_WINS = 2,
+  PROT_ARTNET_ARTNET_WINS = 3
 };
 
 enum p_merge {
   MERGE_LTP = 0,
-  MERGE_HTP = 1
+  MERGE_HTP = 1,
+  MERGE_PRIORITY = 2
+};
+
+// Buffers the DMX drivers get from the ArtNet arena
+enum spare_buffer {
+  SPARE_DMX_A = 0,
+  SPARE_DMX_B = 1,
+  SPARE_DMX_IN = 2,
+  SPARE_COUNT = 3
 };
 
 struct StoreStruct {
@@ -223,6 +259,28 @@ struct StoreStruct {
   uint16_t portApixFXstart;
   uint16_t portBpixFXstart;
 
+  uint8_t portAtiming;
+  uint8_t portBtiming;
+
+  // Source loss policy: hold in seconds, fade in tenths of a second
+  uint8_t portAloss;
+  uint8_t portBloss;
+  uint8_t portAlossHold;
+  uint8_t portBlossHold;
+  uint8_t portAlossFade;
+  uint8_t portBlossFade;
+
+  // DMX input to Artnet: most sends a second (0 for no limit) & keepalive in tenths of a second
+  uint8_t dmxInRate;
+  uint8_t dmxInKeepAlive;
+  bool dmxInLocal;              // Also straight to our own ports on the input's universe
+
+  // Most senders merged on each Artnet port & how long one can go quiet, in seconds, before it's dropped
+  uint8_t portAsources;
+  uint8_t portBsources;
+  uint8_t portAsourceTimeout;
+  uint8_t portBsourceTimeout;
+
 } deviceSettings = {
 
   CONFIG_VERSION,
@@ -280,6 +338,25 @@ struct StoreStruct {
 
   1,                           // portApixFXstart
   1,                           // portBpixFXstart
+
+  DMX_TIMING_STANDARD,         // portAtiming
+  DMX_TIMING_STANDARD,         // portBtiming
+
+  LOSS_HOLD,                   // portAloss
+  LOSS_HOLD,                   // portBloss
+  10,                          // portAlossHold
+  10,                          // portBlossHold
+  30,                          // portAlossFade
+  30,                          // portBlossFade
+
+  44,                          // dmxInRate
+  10,                          // dmxInKeepAlive
+  true,                        // dmxInLocal
+
+  ARTNET_DEFAULT_SOURCES,      // portAsources
+  ARTNET_DEFAULT_SOURCES,      // portBsources
+  ARTNET_SOURCE_TIMEOUT / 1000, // portAsourceTimeout
+  ARTNET_SOURCE_TIMEOUT / 1000, // portBsourceTimeout
 };
 
 static void eepromSave() {
@@ -400,6 +477,10 @@ void setup(void) {
       deviceSettings.portBmode = TYPE_DMX_OUT;
     }
 
+    // Load the patches before opening the Artnet ports they use
+    patchLoad(0);
+    patchLoad(1);
+
     // Setup Artnet Ports & Callbacks
     artStart();
 
@@ -426,11 +507,15 @@ void loop(void) {
   doNodeReport();
   artRDM.handler();
 
+  // Gather patched outputs
+  patchOutput();
+
   yield();
 
   // DMX handlers
   dmxA.handler();
   dmxB.handler();
+  dmxC.handler();
 
   // Do Pixel FX on port A
   if (deviceSettings.portAmode == TYPE_SERIAL_LED && deviceSettings.portApixMode != FX_MODE_PIXEL_MAP) {
@@ -453,15 +538,13 @@ void loop(void) {
 
   // Handle received DMX
   if (newDmxIn) {
-    uint8_t g, p;
+    uint16_t chans = dmxInCopy();
 
-    newDmxIn = false;
+    // Our own outputs get it first, without going through the network
+    if (deviceSettings.dmxInLocal)
+      artRDM.localDMX(portA[0], portA[1], dmxInFrame, chans);
 
-    g = portA[0];
-    p = portA[1];
-
-    IPAddress bc = deviceSettings.dmxInBroadcast;
-    artRDM.sendDMX(g, p, bc, dataIn, 512);
+    dmxInSend();
   }
 
   // Handle rebooting the system
@@ -480,6 +563,228 @@ void loop(void) {
   }
 }
 
+// Copy the pixels that changed in a universe into the pixel buffer
+static void pixSetBuffer(uint8_t pixPort, uint8_t group, uint8_t port, uint16_t numChans, uint16_t uniSize, uint8_t pixLen) {
+  uint16_t start = 0;
+  uint16_t end = numChans;
+
+  if (end > uniSize)
+    end = uniSize;
+
+  // RGBW split packs 3 slots into 4 bytes so always takes the whole universe
+  if (pixLen != 0) {
+    if (!artRDM.getChanged(group, port, &start, &end))
+      return;
+
+    // Round out to whole pixels
+    start -= start % pixLen;
+    end += (pixLen - end % pixLen) % pixLen;
+
+    if (end > uniSize)
+      end = uniSize;
+    if (end > numChans)
+      end = numChans;
+    if (start >= end)
+      return;
+  }
+
+  pixDriver.setBuffer(pixPort, port * uniSize + start, artRDM.getDMX(group, port) + start, end - start);
+}
+
+// Port settings too long for the EEPROM (patches & curves) are kept in SPIFFS as typed into the web page
+static String portFileRead(const char* setting, uint8_t side) {
+  char name[24];
+  sprintf(name, "/%s%c.txt", setting, side ? 'B' : 'A');
+
+  File f = SPIFFS.open(name, "r");
+  if (!f)
+    return String();
+
+  String text = f.readString();
+  f.close();
+
+  return text;
+}
+
+// Returns true if the text changed
+static bool portFileWrite(const char* setting, uint8_t side, const char* text) {
+  char name[24];
+  sprintf(name, "/%s%c.txt", setting, side ? 'B' : 'A');
+
+  if (portFileRead(setting, side) == text)
+    return false;
+
+  File f = SPIFFS.open(name, "w");
+  if (f) {
+    f.print(text);
+    f.close();
+  }
+
+  return true;
+}
+
+// Response curves written as "first-last:curve" or "slot:curve" separated by spaces or commas, slots counting
+// from 1.  Curves are linear, square, scurve, root & invert.  Just checks the text if dmx is 0
+static bool curvesParse(const char* text, espDMX* dmx) {
+  static const char* names[DMX_CURVES] = { "linear", "square", "scurve", "root", "invert" };
+  const char* c = text;
+
+  if (dmx != 0)
+    dmx->clearCurves();
+
+  while (*c != 0) {
+    if (*c == ' ' || *c == ',' || *c == '\n' || *c == '\r') {
+      c++;
+      continue;
+    }
+
+    char* e;
+    unsigned long first = strtoul(c, &e, 10);
+    unsigned long last = first;
+
+    if (*e == '-')
+      last = strtoul(e + 1, &e, 10);
+    if (*e != ':' || first == 0 || last < first || last > DMX_MAX_CHANS)
+      return false;
+
+    c = e + 1;
+    uint8_t curve = 0;
+    size_t len = strcspn(c, " ,\r\n");
+
+    while (curve < DMX_CURVES && (strlen(names[curve]) != len || strncmp(c, names[curve], len) != 0))
+      curve++;
+
+    if (curve == DMX_CURVES)
+      return false;
+
+    if (dmx != 0 && !dmx->setCurve(first - 1, last - first + 1, curve))
+      return false;
+
+    c += len;
+  }
+
+  return true;
+}
+
+// Slots a port's patch can fill: a DMX universe or the pixel buffer.  0 if the port can't be patched
+static uint16_t patchSlots(uint8_t side) {
+  uint8_t mode = side ? deviceSettings.portBmode : deviceSettings.portAmode;
+  uint8_t pixMode = side ? deviceSettings.portBpixMode : deviceSettings.portApixMode;
+  uint8_t config = side ? deviceSettings.portBpixConfig : deviceSettings.portApixConfig;
+  uint32_t numPix = side ? deviceSettings.portBnumPix : deviceSettings.portAnumPix;
+  uint32_t slots = 0;
+
+  if (mode == TYPE_DMX_OUT || mode == TYPE_RDM_OUT)
+    return DMX_MAX_CHANS;
+
+  if (mode != TYPE_SERIAL_LED || pixMode != FX_MODE_PIXEL_MAP)
+    return 0;
+
+  switch (config) {
+    case WS2812_RGB:
+      slots = numPix * 3;
+      break;
+    case WS2812_RGBW:
+    case APA102_RGBB:
+      slots = numPix * 4;
+      break;
+    case WS2812_RGBW_SPLIT:
+      slots = 4 * DMX_MAX_CHANS;
+      break;
+  }
+
+  return (slots > PIX_MAX_BUFFER_SIZE) ? PIX_MAX_BUFFER_SIZE : slots;
+}
+
+// Read & compile a port's patch from SPIFFS.  side is 0 for port A & 1 for port B
+static void patchLoad(uint8_t side) {
+  dmxPatch* patch = side ? &patchB : &patchA;
+  String text = portFileRead("patch", side);
+
+  if (!patch->parse(text.c_str()) || !patch->compile(patchSlots(side)))
+    patch->clear();
+}
+
+// Open the Artnet ports our patches read from that the port modes didn't
+static void patchPorts() {
+  uint8_t inputs = patchA.inputs() | patchB.inputs();
+
+  for (uint8_t x = 0; x < PATCH_INPUTS; x++) {
+    if (!(inputs & (1 << x)))
+      continue;
+
+    uint8_t side = x / 4;
+    uint8_t p = x % 4;
+    uint8_t* ports = side ? portB : portA;
+
+    if (artRDM.getDMX(ports[0], p) != 0)
+      continue;
+
+    if (side == 0) {
+      ports[p + 1] = artRDM.addPort(portA[0], p, deviceSettings.portAuni[p], TYPE_DMX_OUT, deviceSettings.portAmerge);
+      setPortProtocol(portA[0], portA[p + 1], deviceSettings.portAprot);
+      artRDM.setE131Uni(portA[0], portA[p + 1], deviceSettings.portAsACNuni[p]);
+    } else {
+      ports[p + 1] = artRDM.addPort(portB[0], p, deviceSettings.portBuni[p], TYPE_DMX_OUT, deviceSettings.portBmerge);
+      setPortProtocol(portB[0], portB[p + 1], deviceSettings.portBprot);
+      artRDM.setE131Uni(portB[0], portB[p + 1], deviceSettings.portBsACNuni[p]);
+    }
+    setPortLoss(side, ports[p + 1]);
+    setPortSources(side, ports[p + 1]);
+  }
+}
+
+// Mark the patched outputs a universe feeds.  Returns true if its own port is patched so takes nothing 1:1
+static bool patchHandle(uint8_t group, uint8_t port) {
+  uint8_t input = (group == portB[0]) ? port + 4 : port;
+
+  if (patchA.uses(input))
+    patchDirty |= 1;
+  if (patchB.uses(input))
+    patchDirty |= 2;
+
+  return (group == portB[0]) ? patchB.active() : patchA.active();
+}
+
+// Gather each patched output that has new data - one pass however many universes changed - & hand it on
+static void patchOutput() {
+  if (patchDirty == 0)
+    return;
+
+  uint8_t* inputs[PATCH_INPUTS];
+
+  for (uint8_t x = 0; x < 4; x++) {
+    inputs[x] = artRDM.getDMX(portA[0], x);
+    inputs[x + 4] = artRDM.getDMX(portB[0], x);
+  }
+
+  for (uint8_t side = 0; side < 2; side++) {
+    if (!(patchDirty & (1 << side)))
+      continue;
+
+    dmxPatch* patch = side ? &patchB : &patchA;
+    uint16_t len = patch->apply(inputs);
+    uint8_t* out = patch->getBuffer();
+
+    if ((side ? deviceSettings.portBmode : deviceSettings.portAmode) == TYPE_SERIAL_LED) {
+      // Pixel buffers are filled a universe at a time
+      uint8_t config = side ? deviceSettings.portBpixConfig : deviceSettings.portApixConfig;
+      uint16_t uniSize = (config == WS2812_RGB) ? 510 : 512;
+
+      for (uint16_t x = 0; x < len; x += uniSize)
+        pixDriver.setBuffer(side, x, &out[x], (len - x < uniSize) ? len - x : uniSize);
+
+      pixDone = false;
+    } else if (side == 0) {
+      dmxA.chanUpdate(len);
+    } else {
+      dmxB.chanUpdate(len);
+    }
+  }
+
+  patchDirty = 0;
+}
+
 static void dmxHandle(uint8_t group, uint8_t port, uint16_t numChans, bool syncEnabled) {
 
 #ifdef DMX_PROTO_DEBUG
@@ -490,26 +795,27 @@ static void dmxHandle(uint8_t group, uint8_t port, uint16_t numChans, bool syncE
   Serial.printf("DMX Group %u Port %u : %03d %03d %03d %03d %03d %03d\n", group, port, dmxData[0], dmxData[1], dmxData[2], dmxData[3], dmxData[4], dmxData[5], dmxData[6]);
 #endif
 
+  // Patched ports are updated from the loop once all of this pass's universes are in
+  if (patchHandle(group, port))
+    return;
+
   if (portA[0] == group) {
     if (deviceSettings.portAmode == TYPE_SERIAL_LED) {
 
       if (deviceSettings.portApixMode == FX_MODE_PIXEL_MAP) {
         switch (deviceSettings.portApixConfig) {
           case WS2812_RGB:
-            if (numChans > 510) {
-              numChans = 510;
-            }
             // Copy DMX data to the pixels buffer
-            pixDriver.setBuffer(0, port * 510, artRDM.getDMX(group, port), numChans);
+            pixSetBuffer(0, group, port, numChans, 510, 3);
             break;
           case WS2812_RGBW:
-          case WS2812_RGBW_SPLIT:
           case APA102_RGBB:
-            if (numChans > 512) {
-              numChans = 512;
-            }
             // Copy DMX data to the pixels buffer
-            pixDriver.setBuffer(0, port * 512, artRDM.getDMX(group, port), numChans);
+            pixSetBuffer(0, group, port, numChans, 512, 4);
+            break;
+
+          case WS2812_RGBW_SPLIT:
+            pixSetBuffer(0, group, port, numChans, 512, 0);
             break;
         }
 
@@ -550,21 +856,18 @@ static void dmxHandle(uint8_t group, uint8_t port, uint16_t numChans, bool syncE
       if (deviceSettings.portBpixMode == FX_MODE_PIXEL_MAP) {
         switch (deviceSettings.portBpixConfig) {
           case WS2812_RGB:
-            if (numChans > 510) {
-              numChans = 510;
-            }
             // Copy DMX data to the pixels buffer
-            pixDriver.setBuffer(1, port * 510, artRDM.getDMX(group, port), numChans);
+            pixSetBuffer(1, group, port, numChans, 510, 3);
             break;
 
           case WS2812_RGBW:
-          case WS2812_RGBW_SPLIT:
           case APA102_RGBB:
-            if (numChans > 512) {
-              numChans = 512;
-            }
             // Copy DMX data to the pixels buffer
-            pixDriver.setBuffer(1, port * 512, artRDM.getDMX(group, port), numChans);
+            pixSetBuffer(1, group, port, numChans, 512, 4);
+            break;
+
+          case WS2812_RGBW_SPLIT:
+            pixSetBuffer(1, group, port, numChans, 512, 0);
             break;
         }
 
@@ -642,6 +945,96 @@ static void ipHandle() {
   eepromSave();
 }
 
+// Turn sACN on or off for a port & set how it shares the port with Artnet
+static void setPortProtocol(uint8_t group, uint8_t port, uint8_t prot) {
+  artRDM.setE131(group, port, prot != PROT_ARTNET);
+
+  switch (prot) {
+    case PROT_ARTNET_SACN_WINS:
+      artRDM.setProtocolMode(group, port, PROTOCOL_E131);
+      break;
+
+    case PROT_ARTNET_ARTNET_WINS:
+      artRDM.setProtocolMode(group, port, PROTOCOL_ARTNET);
+      break;
+
+    default:
+      artRDM.setProtocolMode(group, port, PROTOCOL_MERGE);
+      break;
+  }
+}
+
+static void lossLookName(char* name, uint8_t side, uint8_t port) {
+  sprintf(name, "/look%c%u.dmx", side ? 'B' : 'A', port);
+}
+
+// Apply a port's source loss settings.  side is 0 for port A & 1 for port B
+static void setPortLoss(uint8_t side, uint8_t port) {
+  uint8_t group = side ? portB[0] : portA[0];
+  uint8_t mode = side ? deviceSettings.portBloss : deviceSettings.portAloss;
+  uint8_t hold = side ? deviceSettings.portBlossHold : deviceSettings.portAlossHold;
+  uint8_t fade = side ? deviceSettings.portBlossFade : deviceSettings.portAlossFade;
+
+  if (port >= 4)
+    return;
+
+  // Allocate the look here so the fade never has to
+  if (mode == LOSS_FADE_SCENE && lossLook[side][port] == 0) {
+    lossLook[side][port] = (uint8_t*) malloc(DMX_BUFFER_SIZE);
+
+    if (lossLook[side][port] != 0) {
+      char name[16];
+      lossLookName(name, side, port);
+      memset(lossLook[side][port], 0, DMX_BUFFER_SIZE);
+
+      File f = SPIFFS.open(name, "r");
+      if (f) {
+        f.read(lossLook[side][port], DMX_BUFFER_SIZE);
+        f.close();
+      }
+    }
+  }
+
+  artRDM.setLossPolicy(group, port, mode, hold * 1000UL, fade * 100UL);
+  artRDM.setLossScene(group, port, (mode == LOSS_FADE_SCENE) ? lossLook[side][port] : 0);
+}
+
+// Apply a port's merge source settings.  side is 0 for port A & 1 for port B
+static void setPortSources(uint8_t side, uint8_t port) {
+  uint8_t group = side ? portB[0] : portA[0];
+
+  if (port >= 4)
+    return;
+
+  artRDM.setMaxSources(group, port, side ? deviceSettings.portBsources : deviceSettings.portAsources);
+  artRDM.setSourceTimeout(group, port, (side ? deviceSettings.portBsourceTimeout : deviceSettings.portAsourceTimeout) * 1000UL);
+}
+
+// Store what each port is outputting as the look it fades to on source loss
+static void storeLossLooks() {
+  for (uint8_t side = 0; side < 2; side++) {
+    uint8_t group = side ? portB[0] : portA[0];
+
+    for (uint8_t port = 0; port < 4; port++) {
+      uint8_t* dmx = artRDM.getDMX(group, port);
+      if (dmx == 0)
+        continue;
+
+      char name[16];
+      lossLookName(name, side, port);
+
+      File f = SPIFFS.open(name, "w");
+      if (f) {
+        f.write(dmx, DMX_BUFFER_SIZE);
+        f.close();
+      }
+
+      if (lossLook[side][port] != 0)
+        memcpy(lossLook[side][port], dmx, DMX_BUFFER_SIZE);
+    }
+  }
+}
+
 static void addressHandle() {
   memcpy(&deviceSettings.nodeName, artRDM.getShortName(), ARTNET_SHORT_NAME_LENGTH);
   memcpy(&deviceSettings.longName, artRDM.getLongName(), ARTNET_LONG_NAME_LENGTH);
@@ -649,23 +1042,23 @@ static void addressHandle() {
   deviceSettings.portAnet = artRDM.getNet(portA[0]);
   deviceSettings.portAsub = artRDM.getSubNet(portA[0]);
   deviceSettings.portAuni[0] = artRDM.getUni(portA[0], portA[1]);
-  deviceSettings.portAmerge = artRDM.getMerge(portA[0], portA[1]);
+  deviceSettings.portAmerge = artRDM.getMergeMode(portA[0], portA[1]);
 
-  if (artRDM.getE131(portA[0], portA[1])) {
-    deviceSettings.portAprot = PROT_ARTNET_SACN;
-  } else {
+  if (!artRDM.getE131(portA[0], portA[1])) {
     deviceSettings.portAprot = PROT_ARTNET;
+  } else if (deviceSettings.portAprot == PROT_ARTNET) {
+    deviceSettings.portAprot = PROT_ARTNET_SACN;
   }
 
   deviceSettings.portBnet = artRDM.getNet(portB[0]);
   deviceSettings.portBsub = artRDM.getSubNet(portB[0]);
   deviceSettings.portBuni[0] = artRDM.getUni(portB[0], portB[1]);
-  deviceSettings.portBmerge = artRDM.getMerge(portB[0], portB[1]);
+  deviceSettings.portBmerge = artRDM.getMergeMode(portB[0], portB[1]);
 
-  if (artRDM.getE131(portB[0], portB[1])) {
-    deviceSettings.portBprot = PROT_ARTNET_SACN;
-  } else {
+  if (!artRDM.getE131(portB[0], portB[1])) {
     deviceSettings.portBprot = PROT_ARTNET;
+  } else if (deviceSettings.portBprot == PROT_ARTNET) {
+    deviceSettings.portBprot = PROT_ARTNET_SACN;
   }
 
   // Store everything to EEPROM
@@ -716,12 +1109,88 @@ static void todFlush(uint8_t group, uint8_t port) {
 }
 
 static void dmxIn(uint16_t num) {
+  portENTER_CRITICAL_ISR(&dataInMux);
+
   // Double buffer switch
   uint8_t* tmp = dataIn;
   dataIn = dmxA.getChans();
+  dataInChans = num;
   dmxA.setBuffer(tmp);
 
   newDmxIn = true;
+  portEXIT_CRITICAL_ISR(&dataInMux);
+}
+
+// Copy the last input frame out of dataIn, which the driver takes back to receive into after the next
+// break.  Slots past the end of a short frame are left over from older ones, so they read as 0
+static uint16_t dmxInCopy() {
+  portENTER_CRITICAL(&dataInMux);
+  uint16_t chans = dataInChans;
+  if (chans > 512)
+    chans = 512;
+  memcpy(dmxInFrame, dataIn, chans);
+  newDmxIn = false;
+  portEXIT_CRITICAL(&dataInMux);
+
+  memset(&dmxInFrame[chans], 0, 512 - chans);
+
+  return chans;
+}
+
+// Length to send against the last frame sent - up to the last slot that isn't 0 or has changed.
+// Buffers are word aligned so they're compared a word at a time, from the end
+static uint16_t dmxInLength(const uint8_t* data, const uint8_t* sent, bool* changed) {
+  const uint32_t* d = (const uint32_t*)data;
+  const uint32_t* s = (const uint32_t*)sent;
+  int16_t x = 512 / 4 - 1;
+  uint16_t len = 0;
+
+  while (x >= 0 && d[x] == 0 && s[x] == 0)
+    x--;
+
+  if (x >= 0) {
+    len = x * 4 + 4;
+    while (data[len - 1] == 0 && sent[len - 1] == 0)
+      len--;
+  }
+
+  *changed = false;
+  for (; x >= 0; x--) {
+    if (d[x] != s[x]) {
+      *changed = true;
+      break;
+    }
+  }
+
+  return len;
+}
+
+// Send DMX input as Artnet when it changes, no more than dmxInRate times a second, with a keepalive every
+// dmxInKeepAlive while frames keep coming.  A change held back by the rate goes with the next frame after
+static void dmxInSend() {
+  uint8_t* data = dmxInFrame;
+  uint16_t len = 512;
+
+  if (dmxInSent != 0) {
+    uint32_t since = millis() - dmxInSentTime;
+    bool changed;
+
+    len = dmxInLength(data, dmxInSent, &changed);
+
+    if (!changed && since < deviceSettings.dmxInKeepAlive * 100UL)
+      return;
+    if (changed && deviceSettings.dmxInRate != 0 && since < 1000UL / deviceSettings.dmxInRate)
+      return;
+
+    memcpy(dmxInSent, data, 512);
+  }
+
+  // Artnet needs at least 2 slots
+  if (len < 2)
+    len = 2;
+
+  dmxInSentTime = millis();
+  artRDM.sendDMX(portA[0], portA[1], deviceSettings.dmxInBroadcast, data, len);
 }
 
 static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
@@ -790,11 +1259,45 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
     case 4:     // Port A
       Serial.println("Saving Port A details");
       {
-        deviceSettings.portAprot = (uint8_t)json["portAprot"];
-        bool e131 = (deviceSettings.portAprot == PROT_ARTNET_SACN) ? true : false;
+        // Check the patch & curves before changing anything
+        const char* patchText = json["portApatch"];
+        const char* curvesText = json["portAcurves"];
+        dmxPatch check;
+
+        if ((patchText != 0 && !check.parse(patchText)) || (curvesText != 0 && !curvesParse(curvesText, 0)))
+          return false;
+
+        // A new patch opens ports so needs a restart
+        if (patchText != 0 && portFileWrite("patch", 0, patchText))
+          doReboot = true;
+
+        if (curvesText != 0) {
+          portFileWrite("curves", 0, curvesText);
+#ifdef DMX_DIR_A
+          curvesParse(curvesText, &dmxA);
+#endif
+        }
 
+        deviceSettings.portAprot = (uint8_t)json["portAprot"];
         deviceSettings.portAmerge = (uint8_t)json["portAmerge"];
 
+        if (json.containsKey("portAtiming") && (uint8_t)json["portAtiming"] < DMX_TIMING_PROFILES) {
+          deviceSettings.portAtiming = (uint8_t)json["portAtiming"];
+          dmxA.setTiming(deviceSettings.portAtiming);
+        }
+
+        if (json.containsKey("portAloss") && (uint8_t)json["portAloss"] <= LOSS_FADE_SCENE) {
+          deviceSettings.portAloss = (uint8_t)json["portAloss"];
+          deviceSettings.portAlossHold = (uint8_t)json["portAlossHold"];
+          deviceSettings.portAlossFade = (uint8_t)json["portAlossFade"];
+        }
+
+        if (json.containsKey("portAsources") && (uint8_t)json["portAsources"] >= 1 && (uint8_t)json["portAsources"] <= ARTNET_MAX_SOURCES)
+          deviceSettings.portAsources = (uint8_t)json["portAsources"];
+
+        if (json.containsKey("portAsourceTimeout") && (uint8_t)json["portAsourceTimeout"] != 0)
+          deviceSettings.portAsourceTimeout = (uint8_t)json["portAsourceTimeout"];
+
         if ((uint8_t)json["portAnet"] < 128) {
           deviceSettings.portAnet = (uint8_t)json["portAnet"];
         }
@@ -812,8 +1315,10 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
             deviceSettings.portAsACNuni[x] = (uint16_t)json["portAsACNuni"][x];
           }
 
-          artRDM.setE131(portA[0], portA[x + 1], e131);
+          setPortProtocol(portA[0], portA[x + 1], deviceSettings.portAprot);
           artRDM.setE131Uni(portA[0], portA[x + 1], deviceSettings.portAsACNuni[x]);
+          setPortLoss(0, portA[x + 1]);
+          setPortSources(0, portA[x + 1]);
         }
 
         uint8_t newMode = json["portAmode"];
@@ -832,6 +1337,12 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
           deviceSettings.dmxInBroadcast = IPAddress(json["dmxInBroadcast"][0], json["dmxInBroadcast"][1], json["dmxInBroadcast"][2], json["dmxInBroadcast"][3]);
         }
 
+        if (newMode == TYPE_DMX_IN && json.containsKey("dmxInRate")) {
+          deviceSettings.dmxInRate = (uint8_t)json["dmxInRate"];
+          deviceSettings.dmxInKeepAlive = (uint8_t)json["dmxInKeepAlive"];
+          deviceSettings.dmxInLocal = (bool)json["dmxInLocal"];
+        }
+
         if (newConfig != oldConfig) {
           // Store the nem mode to settings
           deviceSettings.portApixConfig = newConfig;
@@ -848,7 +1359,7 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
         artRDM.setNet(portA[0], deviceSettings.portAnet);
         artRDM.setSubNet(portA[0], deviceSettings.portAsub);
         artRDM.setUni(portA[0], portA[1], deviceSettings.portAuni[0]);
-        artRDM.setMerge(portA[0], portA[1], deviceSettings.portAmerge);
+        artRDM.setMergeMode(portA[0], portA[1], deviceSettings.portAmerge);
 
         // Lengthen or shorten our pixel strip & handle required Artnet ports
         if (newMode == TYPE_SERIAL_LED && !doReboot) {
@@ -916,7 +1427,7 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
           for (uint8_t x = 1, y = 2; x < 4; x++, y++) {
             if (newLen > (x * 170)) {
               artRDM.setUni(portA[0], portA[y], deviceSettings.portAuni[x]);
-              artRDM.setMerge(portA[0], portA[y], deviceSettings.portAmerge);
+              artRDM.setMergeMode(portA[0], portA[y], deviceSettings.portAmerge);
             }
           }
         }
@@ -931,11 +1442,45 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
     case 5:     // Port B
       Serial.println("Saving Port B details");
       {
-        deviceSettings.portBprot = (uint8_t)json["portBprot"];
-        bool e131 = (deviceSettings.portBprot == PROT_ARTNET_SACN) ? true : false;
+        // Check the patch & curves before changing anything
+        const char* patchText = json["portBpatch"];
+        const char* curvesText = json["portBcurves"];
+        dmxPatch check;
 
+        if ((patchText != 0 && !check.parse(patchText)) || (curvesText != 0 && !curvesParse(curvesText, 0)))
+          return false;
+
+        // A new patch opens ports so needs a restart
+        if (patchText != 0 && portFileWrite("patch", 1, patchText))
+          doReboot = true;
+
+        if (curvesText != 0) {
+          portFileWrite("curves", 1, curvesText);
+#ifdef DMX_DIR_B
+          curvesParse(curvesText, &dmxB);
+#endif
+        }
+
+        deviceSettings.portBprot = (uint8_t)json["portBprot"];
         deviceSettings.portBmerge = (uint8_t)json["portBmerge"];
 
+        if (json.containsKey("portBtiming") && (uint8_t)json["portBtiming"] < DMX_TIMING_PROFILES) {
+          deviceSettings.portBtiming = (uint8_t)json["portBtiming"];
+          dmxB.setTiming(deviceSettings.portBtiming);
+        }
+
+        if (json.containsKey("portBloss") && (uint8_t)json["portBloss"] <= LOSS_FADE_SCENE) {
+          deviceSettings.portBloss = (uint8_t)json["portBloss"];
+          deviceSettings.portBlossHold = (uint8_t)json["portBlossHold"];
+          deviceSettings.portBlossFade = (uint8_t)json["portBlossFade"];
+        }
+
+        if (json.containsKey("portBsources") && (uint8_t)json["portBsources"] >= 1 && (uint8_t)json["portBsources"] <= ARTNET_MAX_SOURCES)
+          deviceSettings.portBsources = (uint8_t)json["portBsources"];
+
+        if (json.containsKey("portBsourceTimeout") && (uint8_t)json["portBsourceTimeout"] != 0)
+          deviceSettings.portBsourceTimeout = (uint8_t)json["portBsourceTimeout"];
+
         if ((uint8_t)json["portBnet"] < 128) {
           deviceSettings.portBnet = (uint8_t)json["portBnet"];
         }
@@ -953,8 +1498,10 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
             deviceSettings.portBsACNuni[x] = (uint16_t)json["portBsACNuni"][x];
           }
 
-          artRDM.setE131(portB[0], portB[x + 1], e131);
+          setPortProtocol(portB[0], portB[x + 1], deviceSettings.portBprot);
           artRDM.setE131Uni(portB[0], portB[x + 1], deviceSettings.portBsACNuni[x]);
+          setPortLoss(1, portB[x + 1]);
+          setPortSources(1, portB[x + 1]);
         }
 
         uint8_t newMode = json["portBmode"];
@@ -982,7 +1529,7 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
         artRDM.setNet(portB[0], deviceSettings.portBnet);
         artRDM.setSubNet(portB[0], deviceSettings.portBsub);
         artRDM.setUni(portB[0], portB[1], deviceSettings.portBuni[0]);
-        artRDM.setMerge(portB[0], portB[1], deviceSettings.portBmerge);
+        artRDM.setMergeMode(portB[0], portB[1], deviceSettings.portBmerge);
 
         // Lengthen or shorten our pixel strip & handle required Artnet ports
         if (newMode == TYPE_SERIAL_LED && !doReboot) {
@@ -1046,7 +1593,7 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
           for (uint8_t x = 1, y = 2; x < 4; x++, y++) {
             if (newLen > (x * 170)) {
               artRDM.setUni(portB[0], portB[y], deviceSettings.portBuni[x]);
-              artRDM.setMerge(portB[0], portB[y], deviceSettings.portBmerge);
+              artRDM.setMergeMode(portB[0], portB[y], deviceSettings.portBmerge);
             }
           }
         }
@@ -1059,8 +1606,10 @@ static bool ajaxSave(uint8_t page, DynamicJsonDocument& json) {
       break;
 
     case 6:     // Scenes
-      Serial.println("ERROR: Not implemented - Scenes");
-      // Not yet implemented
+      if ((uint8_t)json["lossLookStore"] == 1) {
+        Serial.println("Storing source loss looks");
+        storeLossLooks();
+      }
 
       return true;
       break;
@@ -1198,6 +1747,13 @@ static void ajaxLoad(uint8_t page, JsonDocument& jsonReply) {
             jsonReply["portBpixConfig"] = "APA102 RGBB";
             break;
         }
+
+        if (deviceSettings.portAmode == TYPE_DMX_OUT || deviceSettings.portAmode == TYPE_RDM_OUT)
+          jsonReply["portAoutput"] = dmxOutputString(dmxA);
+        else if (deviceSettings.portAmode == TYPE_DMX_IN)
+          jsonReply["portAoutput"] = dmxInputString(dmxA);
+        if (deviceSettings.portBmode == TYPE_DMX_OUT || deviceSettings.portBmode == TYPE_RDM_OUT)
+          jsonReply["portBoutput"] = dmxOutputString(dmxB);
       }
 
       jsonReply["sceneStatus"] = "Not outputting<br />0 Scenes Recorded<br />0 of 250KB used";
@@ -1268,6 +1824,14 @@ static void ajaxLoad(uint8_t page, JsonDocument& jsonReply) {
       }
 
       jsonReply["portAmerge"] = deviceSettings.portAmerge;
+      jsonReply["portAtiming"] = deviceSettings.portAtiming;
+      jsonReply["portAloss"] = deviceSettings.portAloss;
+      jsonReply["portAlossHold"] = deviceSettings.portAlossHold;
+      jsonReply["portAlossFade"] = deviceSettings.portAlossFade;
+      jsonReply["portAsources"] = deviceSettings.portAsources;
+      jsonReply["portAsourceTimeout"] = deviceSettings.portAsourceTimeout;
+      jsonReply["portApatch"] = portFileRead("patch", 0);
+      jsonReply["portAcurves"] = portFileRead("curves", 0);
       jsonReply["portAnet"] = deviceSettings.portAnet;
       jsonReply["portAsub"] = deviceSettings.portAsub;
       jsonReply["portAnumPix"] = deviceSettings.portAnumPix;
@@ -1275,6 +1839,9 @@ static void ajaxLoad(uint8_t page, JsonDocument& jsonReply) {
       jsonReply["portApixMode"] = deviceSettings.portApixMode;
       jsonReply["portApixConfig"] = deviceSettings.portApixConfig;
       jsonReply["portApixFXstart"] = deviceSettings.portApixFXstart;
+      jsonReply["dmxInRate"] = deviceSettings.dmxInRate;
+      jsonReply["dmxInKeepAlive"] = deviceSettings.dmxInKeepAlive;
+      jsonReply["dmxInLocal"] = deviceSettings.dmxInLocal;
 
       for (uint8_t x = 0; x < 4; x++) {
         portAuni.add(deviceSettings.portAuni[x]);
@@ -1296,6 +1863,14 @@ static void ajaxLoad(uint8_t page, JsonDocument& jsonReply) {
       jsonReply["portBmode"] = deviceSettings.portBmode;
       jsonReply["portBprot"] = deviceSettings.portBprot;
       jsonReply["portBmerge"] = deviceSettings.portBmerge;
+      jsonReply["portBtiming"] = deviceSettings.portBtiming;
+      jsonReply["portBloss"] = deviceSettings.portBloss;
+      jsonReply["portBlossHold"] = deviceSettings.portBlossHold;
+      jsonReply["portBlossFade"] = deviceSettings.portBlossFade;
+      jsonReply["portBsources"] = deviceSettings.portBsources;
+      jsonReply["portBsourceTimeout"] = deviceSettings.portBsourceTimeout;
+      jsonReply["portBpatch"] = portFileRead("patch", 1);
+      jsonReply["portBcurves"] = portFileRead("curves", 1);
       jsonReply["portBnet"] = deviceSettings.portBnet;
       jsonReply["portBsub"] = deviceSettings.portBsub;
       jsonReply["portBnumPix"] = deviceSettings.portBnumPix;
@@ -1324,6 +1899,7 @@ static void ajaxLoad(uint8_t page, JsonDocument& jsonReply) {
       jsonReply.remove("portBsACNuni");
       jsonReply.remove("dmxInBroadcast");
 
+      jsonReply["lossLookStore"] = 0;
 
       jsonReply["success"] = 1;
       break;
@@ -1468,10 +2044,119 @@ static void webFirmwareUpload() {
   }
 }
 
+/* firmwareHandle()
+    stream ArtFirmwareMaster blocks into the OTA partition
+*/
+static bool firmwareHandle(uint8_t type, uint8_t* data, uint16_t length, uint32_t totalLength) {
+  switch (type) {
+    case ARTNET_FIRM_FIRST:
+      if (Update.isRunning()) {
+        Update.abort();
+      }
+
+      if (!Update.begin(totalLength)) {
+        Serial.println("ERROR: Art-Net firmware upload - insufficient space");
+        break;
+      }
+
+      Serial.printf("Art-Net firmware upload started, %u bytes\n", totalLength);
+      artRDM.setNodeReport("Firmware upload in progress", ARTNET_RC_POWER_OK);
+      nextNodeReport = millis() + ARTNET_FIRMWARE_TIMEOUT;
+
+      // fall through - the first block carries data too
+    case ARTNET_FIRM_CONT:
+      if (Update.write(data, length) == length) {
+        return true;
+      }
+      Serial.println("ERROR: Art-Net firmware upload - failed to save");
+      break;
+
+    case ARTNET_FIRM_LAST:
+      if (Update.write(data, length) == length && Update.end(true)) {
+        Serial.println("Art-Net firmware upload complete");
+        artRDM.setNodeReport("Firmware upload complete. Restarting", ARTNET_RC_POWER_OK);
+        doReboot = true;
+        return true;
+      }
+      Serial.println("ERROR: Art-Net firmware upload - image rejected");
+      break;
+
+    default:
+      // Upload timed out or was replaced by another
+      Serial.println("ERROR: Art-Net firmware upload aborted");
+      break;
+  }
+
+  if (Update.isRunning()) {
+    Update.abort();
+  }
+
+  artRDM.setNodeReport("Firmware upload failed", ARTNET_RC_FIRMWARE_FAIL);
+  strcpy(nodeError, "Firmware upload failed");
+  nextNodeReport = millis() + 10000;
+  nodeErrorTimeout = millis() + 30000;
+
+  return false;
+}
+
+// A break or MAB shorter than receivers accept.  GoodOutput has no bit for this so it only
+// shows in the node report & on the status page
+static bool dmxTimingFault(dmx_stats& st) {
+  return st.frames != 0 && ((st.breakUs != 0 && st.breakUs < 88) || (st.mabUs != 0 && st.mabUs < 8));
+}
+
+// What's actually on the wire, measured by the DMX driver
+static String dmxOutputString(espDMX& dmx) {
+  dmx_stats st;
+  dmx.getStats(&st);
+
+  // Room for every counter at its full 10 digits
+  char c[352];
+  snprintf(c, sizeof(c), "%u fps, %u slots<br />Break %uus, MAB %uus<br />Latency %uus (max %uus)<br />%u keepalive, %u held for RDM<br />Jitter <8/32/128/512us <2/8/32ms more:",
+          st.fps, st.slots, st.breakUs, st.mabUs, st.latencyAvg, st.latencyMax, st.keepAlives, st.rdmPreempted);
+
+  for (uint8_t x = 0; x < DMX_JITTER_BUCKETS; x++)
+    snprintf(c + strlen(c), sizeof(c) - strlen(c), " %u", st.jitter[x]);
+
+  if (dmxTimingFault(st))
+    snprintf(c + strlen(c), sizeof(c) - strlen(c), "<br />Break or MAB out of spec");
+
+  return String(c);
+}
+
+// What the console on a DMX input is sending
+static String dmxInputString(espDMX& dmx) {
+  dmx_stats st;
+  dmx.getStats(&st);
+
+  char c[160];
+  snprintf(c, sizeof(c), "%u fps, %u slots<br />Break & MAB %uus<br />%u framing errors, %u short frames, %u other start codes",
+          st.fps, st.slots, st.breakUs, st.frameErrors, st.shortFrames, st.startCodes);
+
+  return String(c);
+}
+
+// GoodOutput shows if frames are going out.  Returns true if the timing is out of spec
+static bool dmxOutputStatus(espDMX& dmx, uint8_t* ports, uint8_t mode) {
+  if (mode != TYPE_DMX_OUT && mode != TYPE_RDM_OUT)
+    return false;
+
+  dmx_stats st;
+  dmx.getStats(&st);
+
+  bool active = st.frames != 0 && (millis() - st.lastFrame) < 1000;
+  artRDM.setOutputStatus(ports[0], ports[1], active);
+
+  return dmxTimingFault(st);
+}
+
 static void doNodeReport() {
   if (nextNodeReport > millis())
     return;
 
+  bool faultA = dmxOutputStatus(dmxA, portA, deviceSettings.portAmode);
+  bool faultB = dmxOutputStatus(dmxB, portB, deviceSettings.portBmode);
+
   static char c[128] = { 0 };
 
   if (nodeErrorTimeout > millis()) {
@@ -1485,6 +2170,10 @@ static void doNodeReport() {
     nodeErrorShowing = true;
     strcpy(c, nodeError);
 
+  } else if (faultA || faultB) {
+    nodeErrorShowing = false;
+    sprintf(c, "DMX timing out of spec:%s%s", faultA ? " PortA" : "", faultB ? " PortB" : "");
+
   } else {
     nodeErrorShowing = false;
 
@@ -1538,25 +2227,37 @@ static void portSetup() {
   if (deviceSettings.portAmode == TYPE_DMX_OUT || deviceSettings.portAmode == TYPE_RDM_OUT) {
 
 #ifdef DMX_DIR_A
-    dmxA.begin(DMX_DIR_A, artRDM.getDMX(portA[0], portA[1]));
+    dmxA.setTiming(deviceSettings.portAtiming);
+    dmxA.begin(DMX_DIR_A, patchA.active() ? patchA.getBuffer() : artRDM.getDMX(portA[0], portA[1]), artRDM.getSpareBuffer(SPARE_DMX_A));
     if (deviceSettings.portAmode == TYPE_RDM_OUT && !dmxA.rdmEnabled()) {
       dmxA.rdmEnable(ESTA_MAN, ESTA_DEV);
       dmxA.rdmSetCallBack(rdmReceivedA);
       dmxA.todSetCallBack(sendTodA);
     }
+    curvesParse(portFileRead("curves", 0).c_str(), &dmxA);
 #endif  // #ifdef DMX_DIR_A
 
   } else if (deviceSettings.portAmode == TYPE_DMX_IN) {
 
 #ifdef DMX_DIR_A
-    dmxA.begin(DMX_DIR_A, artRDM.getDMX(portA[0], portA[1]));
+    dmxA.begin(DMX_DIR_A, artRDM.getDMX(portA[0], portA[1]), artRDM.getSpareBuffer(SPARE_DMX_A));
     dmxA.dmxIn(true);
     dmxA.setInputCallback(dmxIn);
 #endif  // #ifdef DMX_DIR_A
 
-    dataIn = (uint8_t*) malloc(sizeof(uint8_t) * 512);
+    dataIn = artRDM.getSpareBuffer(SPARE_DMX_IN);
+    if (dataIn == 0)
+      dataIn = (uint8_t*) malloc(sizeof(uint8_t) * 512);
     memset(dataIn, 0, 512);
 
+    dmxInFrame = (uint8_t*) malloc(sizeof(uint8_t) * 512);
+    memset(dmxInFrame, 0, 512);
+
+    // Without it every frame is sent in full
+    dmxInSent = (uint8_t*) malloc(sizeof(uint8_t) * 512);
+    if (dmxInSent != 0)
+      memset(dmxInSent, 0, 512);
+
   } else if (deviceSettings.portAmode == TYPE_SERIAL_LED) {
     pixDriver.setStrip(0, deviceSettings.portAnumPix, deviceSettings.portApixConfig);
   }
@@ -1564,12 +2265,14 @@ static void portSetup() {
   if (deviceSettings.portBmode == TYPE_DMX_OUT || deviceSettings.portBmode == TYPE_RDM_OUT) {
 
 #ifdef DMX_DIR_B
-    dmxB.begin(DMX_DIR_B, artRDM.getDMX(portB[0], portB[1]));
+    dmxB.setTiming(deviceSettings.portBtiming);
+    dmxB.begin(DMX_DIR_B, patchB.active() ? patchB.getBuffer() : artRDM.getDMX(portB[0], portB[1]), artRDM.getSpareBuffer(SPARE_DMX_B));
     if (deviceSettings.portBmode == TYPE_RDM_OUT && !dmxB.rdmEnabled()) {
       dmxB.rdmEnable(ESTA_MAN, ESTA_DEV);
       dmxB.rdmSetCallBack(rdmReceivedB);
       dmxB.todSetCallBack(sendTodB);
     }
+    curvesParse(portFileRead("curves", 1).c_str(), &dmxB);
 #endif  // #ifdef DMX_DIR_B
 
   } else if (deviceSettings.portBmode == TYPE_SERIAL_LED)  {
@@ -1592,8 +2295,6 @@ static void artStart() {
   // Add Group
   portA[0] = artRDM.addGroup(deviceSettings.portAnet, deviceSettings.portAsub);
 
-  bool e131 = (deviceSettings.portAprot == PROT_ARTNET_SACN) ? true : false;
-
   // WS2812 uses TYPE_DMX_OUT - the rest use the value assigned
   if (deviceSettings.portAmode == TYPE_SERIAL_LED) {
     portA[1] = artRDM.addPort(portA[0], 0, deviceSettings.portAuni[0], TYPE_DMX_OUT, deviceSettings.portAmerge);
@@ -1601,8 +2302,10 @@ static void artStart() {
     portA[1] = artRDM.addPort(portA[0], 0, deviceSettings.portAuni[0], deviceSettings.portAmode, deviceSettings.portAmerge);
   }
 
-  artRDM.setE131(portA[0], portA[1], e131);
+  setPortProtocol(portA[0], portA[1], deviceSettings.portAprot);
   artRDM.setE131Uni(portA[0], portA[1], deviceSettings.portAsACNuni[0]);
+  setPortLoss(0, portA[1]);
+  setPortSources(0, portA[1]);
 
   // Add extra Artnet ports for WS2812
   if (deviceSettings.portAmode == TYPE_SERIAL_LED && deviceSettings.portApixMode == FX_MODE_PIXEL_MAP) {
@@ -1626,27 +2329,32 @@ static void artStart() {
     if (deviceSettings.portAnumPix > lim1) {
       portA[2] = artRDM.addPort(portA[0], 1, deviceSettings.portAuni[1], TYPE_DMX_OUT, deviceSettings.portAmerge);
 
-      artRDM.setE131(portA[0], portA[2], e131);
+      setPortProtocol(portA[0], portA[2], deviceSettings.portAprot);
       artRDM.setE131Uni(portA[0], portA[2], deviceSettings.portAsACNuni[1]);
+      setPortLoss(0, portA[2]);
+      setPortSources(0, portA[2]);
     }
     if (deviceSettings.portAnumPix > lim2) {
       portA[3] = artRDM.addPort(portA[0], 2, deviceSettings.portAuni[2], TYPE_DMX_OUT, deviceSettings.portAmerge);
 
-      artRDM.setE131(portA[0], portA[3], e131);
+      setPortProtocol(portA[0], portA[3], deviceSettings.portAprot);
       artRDM.setE131Uni(portA[0], portA[3], deviceSettings.portAsACNuni[2]);
+      setPortLoss(0, portA[3]);
+      setPortSources(0, portA[3]);
     }
     if (deviceSettings.portAnumPix > lim3) {
       portA[4] = artRDM.addPort(portA[0], 3, deviceSettings.portAuni[3], TYPE_DMX_OUT, deviceSettings.portAmerge);
 
-      artRDM.setE131(portA[0], portA[4], e131);
+      setPortProtocol(portA[0], portA[4], deviceSettings.portAprot);
       artRDM.setE131Uni(portA[0], portA[4], deviceSettings.portAsACNuni[3]);
+      setPortLoss(0, portA[4]);
+      setPortSources(0, portA[4]);
     }
   }
 
 
   // Add Group
   portB[0] = artRDM.addGroup(deviceSettings.portBnet, deviceSettings.portBsub);
-  e131 = (deviceSettings.portBprot == PROT_ARTNET_SACN) ? true : false;
 
   // WS2812 uses TYPE_DMX_OUT - the rest use the value assigned
   if (deviceSettings.portBmode == TYPE_SERIAL_LED) {
@@ -1655,8 +2363,10 @@ static void artStart() {
     portB[1] = artRDM.addPort(portB[0], 0, deviceSettings.portBuni[0], deviceSettings.portBmode, deviceSettings.portBmerge);
   }
 
-  artRDM.setE131(portB[0], portB[1], e131);
+  setPortProtocol(portB[0], portB[1], deviceSettings.portBprot);
   artRDM.setE131Uni(portB[0], portB[1], deviceSettings.portBsACNuni[0]);
+  setPortLoss(1, portB[1]);
+  setPortSources(1, portB[1]);
 
   // Add extra Artnet ports for WS2812
   if (deviceSettings.portBmode == TYPE_SERIAL_LED && deviceSettings.portBpixMode == FX_MODE_PIXEL_MAP) {
@@ -1680,23 +2390,32 @@ static void artStart() {
     if (deviceSettings.portBnumPix > lim1) {
       portB[2] = artRDM.addPort(portB[0], 1, deviceSettings.portBuni[1], TYPE_DMX_OUT, deviceSettings.portBmerge);
 
-      artRDM.setE131(portB[0], portB[2], e131);
+      setPortProtocol(portB[0], portB[2], deviceSettings.portBprot);
       artRDM.setE131Uni(portB[0], portB[2], deviceSettings.portBsACNuni[1]);
+      setPortLoss(1, portB[2]);
+      setPortSources(1, portB[2]);
     }
     if (deviceSettings.portBnumPix > lim2) {
       portB[3] = artRDM.addPort(portB[0], 2, deviceSettings.portBuni[2], TYPE_DMX_OUT, deviceSettings.portBmerge);
 
-      artRDM.setE131(portB[0], portB[3], e131);
+      setPortProtocol(portB[0], portB[3], deviceSettings.portBprot);
       artRDM.setE131Uni(portB[0], portB[3], deviceSettings.portBsACNuni[2]);
+      setPortLoss(1, portB[3]);
+      setPortSources(1, portB[3]);
     }
     if (deviceSettings.portBnumPix > lim3) {
       portB[4] = artRDM.addPort(portB[0], 3, deviceSettings.portBuni[3], TYPE_DMX_OUT, deviceSettings.portBmerge);
 
-      artRDM.setE131(portB[0], portB[4], e131);
+      setPortProtocol(portB[0], portB[4], deviceSettings.portBprot);
       artRDM.setE131Uni(portB[0], portB[4], deviceSettings.portBsACNuni[3]);
+      setPortLoss(1, portB[4]);
+      setPortSources(1, portB[4]);
     }
   }
 
+  // Universes our patches read from
+  patchPorts();
+
   // Add required callback functions
   artRDM.setArtDMXCallback(dmxHandle);
   artRDM.setArtRDMCallback(rdmHandle);
@@ -1705,6 +2424,7 @@ static void artStart() {
   artRDM.setArtAddressCallback(addressHandle);
   artRDM.setTODRequestCallback(todRequest);
   artRDM.setTODFlushCallback(todFlush);
+  artRDM.setFirmwareCallback(firmwareHandle);
 
   switch (rtc_get_reset_reason(xPortGetCoreID())) {
     case NO_MEAN:
@@ -1746,9 +2466,13 @@ static void artStart() {
       break;
   }
 
-  // Start artnet
+  // Start artnet - this lays out all our buffers, including those for the DMX drivers
+  artRDM.reserveBuffers(SPARE_COUNT);
   artRDM.begin();
 
+  // All DMX & merge buffers are allocated by now - nothing more is taken while running
+  Serial.printf("DMX buffers: %u bytes, free heap: %u bytes\n", artRDM.getBufferBytes(), ESP.getFreeHeap());
+
   yield();
 }
 
@@ -16,16 +16,26 @@
 #define artnet_data_h
 
 #define ARTNET_PORT 6454
-#define ARTNET_BUFFER_MAX 600
+#define ARTNET_BUFFER_MAX 1064
 #define ARTNET_REPLY_SIZE 239
 #define ARTNET_IP_PROG_REPLY_SIZE 34
 #define ARTNET_RDM_REPLY_SIZE 24
 #define ARTNET_TOD_DATA_SIZE 28
+#define ARTNET_FIRMWARE_REPLY_SIZE 36
+#define ARTNET_FIRMWARE_HEADER_SIZE 40
+#define ARTNET_FIRMWARE_BLOCK_SIZE 1024
+#define ARTNET_FIRMWARE_TIMEOUT 30000
 #define ARTNET_ADDRESS_OFFSET 18
 #define ARTNET_SHORT_NAME_LENGTH 18
 #define ARTNET_LONG_NAME_LENGTH 64
 #define ARTNET_NODE_REPORT_LENGTH 64
 #define ARTNET_CANCEL_MERGE_TIMEOUT 2500
+#define ARTNET_MAX_SOURCES 8
+#define ARTNET_DEFAULT_SOURCES 2
+#define ARTNET_SOURCE_TIMEOUT 10000
+#define ARTNET_MERGE_SWEEP_INTERVAL 100
+#define ARTNET_LOSS_STEP_INTERVAL 23
+#define ARTNET_DEFAULT_PRIORITY 100
 #define DMX_BUFFER_SIZE 512
 #define DMX_MAX_CHANS 512
 
@@ -85,4 +95,17 @@
 #define ARTNET_AC_ACN_SEL_2 0x72
 #define ARTNET_AC_ACN_SEL_3 0x73
 
+// Artnet Firmware Master block types
+#define ARTNET_FIRM_FIRST 0x00
+#define ARTNET_FIRM_CONT 0x01
+#define ARTNET_FIRM_LAST 0x02
+#define ARTNET_UBEA_FIRST 0x03
+#define ARTNET_UBEA_CONT 0x04
+#define ARTNET_UBEA_LAST 0x05
+
+// Artnet Firmware Reply codes
+#define ARTNET_FIRM_BLOCK_GOOD 0x00
+#define ARTNET_FIRM_ALL_GOOD 0x01
+#define ARTNET_FIRM_FAIL 0xFF
+
 #endif
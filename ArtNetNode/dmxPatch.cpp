@@ -0,0 +1,166 @@
+/*
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#include "dmxPatch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// What unpatched slots & closed inputs read
+static const uint8_t patchZero[PATCH_UNIVERSE] = { 0 };
+
+dmxPatch::dmxPatch(void) {
+  _table = 0;
+  _out = 0;
+  clear();
+}
+
+dmxPatch::~dmxPatch(void) {
+  clear();
+}
+
+void dmxPatch::clear() {
+  free(_table);
+  free(_out);
+
+  _table = 0;
+  _out = 0;
+  _size = 0;
+  _inputs = 0;
+  _numRoutes = 0;
+}
+
+// Route count slots from input/inSlot to outSlot.  Slots count from 0.  Later routes win where they overlap
+bool dmxPatch::addRoute(uint8_t input, uint16_t inSlot, uint16_t outSlot, uint16_t count) {
+  if (_numRoutes >= PATCH_MAX_ROUTES || input >= PATCH_INPUTS || count == 0 || inSlot + count > PATCH_UNIVERSE)
+    return false;
+
+  patch_route* r = &_routes[_numRoutes++];
+  r->input = input;
+  r->inSlot = inSlot;
+  r->outSlot = outSlot;
+  r->count = count;
+
+  return true;
+}
+
+// Read routes written as "input:slot>outSlot*count" separated by spaces or commas, all counting from 1.
+// Inputs 1-4 are Artnet ports A1-A4 & 5-8 are B1-B4.  "*count" can be left off for a single slot
+bool dmxPatch::parse(const char* text) {
+  clear();
+
+  const char* c = text;
+
+  while (*c != 0) {
+    if (*c == ' ' || *c == ',' || *c == '\n' || *c == '\r') {
+      c++;
+      continue;
+    }
+
+    char* e;
+    unsigned long input = strtoul(c, &e, 10);
+    if (*e != ':')
+      return false;
+
+    unsigned long inSlot = strtoul(e + 1, &e, 10);
+    if (*e != '>')
+      return false;
+
+    unsigned long outSlot = strtoul(e + 1, &e, 10);
+    unsigned long count = 1;
+    if (*e == '*')
+      count = strtoul(e + 1, &e, 10);
+
+    // Check the full values - addRoute() takes them as uint8_t & uint16_t.  Output slots can run
+    // past 512 on a pixel strip
+    if (input == 0 || input > PATCH_INPUTS || inSlot == 0 || inSlot > PATCH_UNIVERSE || count > PATCH_UNIVERSE)
+      return false;
+    if (outSlot == 0 || outSlot + count - 1 > 0xFFFF)
+      return false;
+
+    if (!addRoute(input - 1, inSlot - 1, outSlot - 1, count))
+      return false;
+
+    c = e;
+  }
+
+  return true;
+}
+
+// Build the gather table & output buffer for an output of maxSlots.  Only called when setting up ports
+bool dmxPatch::compile(uint16_t maxSlots) {
+  free(_table);
+  free(_out);
+
+  _table = 0;
+  _out = 0;
+  _size = 0;
+  _inputs = 0;
+
+  if (_numRoutes == 0 || maxSlots == 0)
+    return false;
+
+  // Output runs to the last patched slot
+  for (uint8_t x = 0; x < _numRoutes; x++) {
+    uint32_t end = _routes[x].outSlot + _routes[x].count;
+    if (end > maxSlots)
+      end = maxSlots;
+    if (end > _size)
+      _size = end;
+  }
+
+  if (_size == 0)
+    return false;
+
+  _table = (uint16_t*) malloc(_size * sizeof(uint16_t));
+  _out = (uint8_t*) malloc(maxSlots);
+
+  if (_table == 0 || _out == 0) {
+    clear();
+    return false;
+  }
+
+  memset(_out, 0, maxSlots);
+
+  for (uint16_t x = 0; x < _size; x++)
+    _table[x] = PATCH_UNPATCHED;
+
+  for (uint8_t x = 0; x < _numRoutes; x++) {
+    patch_route* r = &_routes[x];
+
+    for (uint16_t y = 0; y < r->count && r->outSlot + y < _size; y++)
+      _table[r->outSlot + y] = (r->input << 9) | (r->inSlot + y);
+
+    _inputs |= (1 << r->input);
+  }
+
+  return true;
+}
+
+// Gather the output from inputs[PATCH_INPUTS] (0 for closed ports).  Returns the number of slots
+uint16_t dmxPatch::apply(uint8_t** inputs) {
+  if (_table == 0)
+    return 0;
+
+  const uint8_t* src[PATCH_INPUTS + 1];
+
+  for (uint8_t x = 0; x < PATCH_INPUTS; x++)
+    src[x] = (inputs[x] != 0) ? inputs[x] : patchZero;
+  src[PATCH_INPUTS] = patchZero;
+
+  const uint16_t* t = _table;
+  uint8_t* dst = _out;
+
+  for (uint16_t x = 0; x < _size; x++)
+    dst[x] = src[t[x] >> 9][t[x] & (PATCH_UNIVERSE - 1)];
+
+  return _size;
+}
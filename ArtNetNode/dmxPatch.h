@@ -0,0 +1,69 @@
+/*
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef dmxPatch_h
+#define dmxPatch_h
+
+#include <stdint.h>
+
+#define PATCH_INPUTS      8       // Artnet ports A1-A4 then B1-B4
+#define PATCH_MAX_ROUTES  32
+#define PATCH_UNIVERSE    512
+
+// Gather table entries are (input << 9) | slot.  Unpatched slots read from an input that's always 0
+#define PATCH_UNPATCHED   (PATCH_INPUTS << 9)
+
+struct patch_route {
+  uint8_t input;
+  uint16_t inSlot;
+  uint16_t outSlot;
+  uint16_t count;
+};
+
+// Patch for one output port.  Routes are compiled into a table with an entry per output slot saying where
+// to read it from, so applying the patch is one pass over the output
+class dmxPatch {
+  public:
+    dmxPatch();
+    ~dmxPatch();
+    void clear();
+    bool addRoute(uint8_t input, uint16_t inSlot, uint16_t outSlot, uint16_t count);
+    bool parse(const char* text);
+    bool compile(uint16_t maxSlots);
+    uint16_t apply(uint8_t** inputs);
+
+    bool active(void) {
+      return (_table != 0);
+    }
+    bool uses(uint8_t input) {
+      return (_table != 0 && (_inputs & (1 << input)));
+    }
+    uint8_t inputs(void) {
+      return _inputs;
+    }
+    uint8_t* getBuffer(void) {
+      return _out;
+    }
+    uint16_t size(void) {
+      return _size;
+    }
+
+  private:
+    patch_route _routes[PATCH_MAX_ROUTES];
+    uint8_t _numRoutes;
+
+    uint16_t* _table;
+    uint8_t* _out;
+    uint16_t _size;
+    uint8_t _inputs;
+};
+
+#endif
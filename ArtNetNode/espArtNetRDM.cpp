@@ -17,6 +17,287 @@ static void artClearDMXBuffer(uint8_t* buf) {
   memset(buf, 0, DMX_BUFFER_SIZE);
 }
 
+// HTP merge: dst = max(a, b) for len slots.  dst can be the same buffer as a or b
+static void artMergeHTP(uint8_t* dst, const uint8_t* a, const uint8_t* b, uint16_t len) {
+  for (uint16_t x = 0; x < len; x++)
+    dst[x] = (a[x] > b[x]) ? a[x] : b[x];
+}
+
+// Find the slots [start, end) that differ between 2 buffers.  Returns false if they match
+static bool artChangedRange(const uint8_t* a, const uint8_t* b, uint16_t len, uint16_t* start, uint16_t* end) {
+  bool aligned = (((uintptr_t)a | (uintptr_t)b) & 3) == 0;
+  uint16_t s = 0;
+  uint16_t e = len;
+
+  // Skip matching slots from the front, 4 at a time where we can
+  if (aligned) {
+    while (s + 4 <= len && *(const uint32_t*)&a[s] == *(const uint32_t*)&b[s])
+      s += 4;
+  }
+  while (s < len && a[s] == b[s])
+    s++;
+
+  if (s == len)
+    return false;
+
+  // Then from the back.  a[s] != b[s] so these always stop before s
+  while ((!aligned || (e & 3)) && a[e - 1] == b[e - 1])
+    e--;
+  if (aligned && !(e & 3)) {
+    while (e >= s + 4 && *(const uint32_t*)&a[e - 4] == *(const uint32_t*)&b[e - 4])
+      e -= 4;
+    while (a[e - 1] == b[e - 1])
+      e--;
+  }
+
+  *start = s;
+  *end = e;
+  return true;
+}
+
+// Arena slot layout: port_def, DMX output buffer, source buffers, LTP slot owners.  Each part is word aligned
+static const uint32_t artPortSize = (sizeof(port_def) + 3) & ~3;
+
+static inline uint32_t artSlotSize(uint8_t sources) {
+  return artPortSize + (sources + 2) * DMX_BUFFER_SIZE;
+}
+
+// Free a port's source buffers and forget its sources
+static void artReleaseSources(port_def* port) {
+  if (port->ownSources)
+    free(port->sourceBuffer);
+
+  port->sourceBuffer = 0;
+  port->ownSources = false;
+  port->slotOwner = 0;
+
+  for (uint8_t x = 0; x < ARTNET_MAX_SOURCES; x++)
+    port->sources[x].buffer = 0;
+
+  port->numSources = 0;
+  port->merging = false;
+  port->mergeValid = false;
+}
+
+// Allocate and clear a buffer for each of a port's sources, plus the LTP slot owners.
+// Only called when setting up ports so DMX packets never wait on the heap
+static bool artAllocSources(port_def* port) {
+  if (port->portType == DMX_IN) {
+    artReleaseSources(port);
+    return true;
+  }
+
+  if (port->sourceBuffer != 0)
+    return true;
+
+  // Use our arena slot if it's big enough
+  if (port->slot != 0 && port->maxSources <= port->slotSources) {
+    port->sourceBuffer = &port->slot[artPortSize + DMX_BUFFER_SIZE];
+  } else {
+    port->sourceBuffer = (uint8_t*) malloc((port->maxSources + 1) * DMX_BUFFER_SIZE);
+    if (port->sourceBuffer == 0)
+      return false;
+
+    port->ownSources = true;
+  }
+
+  delay(0);
+  memset(port->sourceBuffer, 0, (port->maxSources + 1) * DMX_BUFFER_SIZE);
+  delay(0);
+
+  for (uint8_t x = 0; x < port->maxSources; x++)
+    port->sources[x].buffer = &port->sourceBuffer[x * DMX_BUFFER_SIZE];
+
+  port->slotOwner = &port->sourceBuffer[port->maxSources * DMX_BUFFER_SIZE];
+
+  return true;
+}
+
+// Which buffer in the pool a source uses.  Unlike its table index this doesn't change
+static inline uint8_t artSourceSlot(port_def* port, uint8_t x) {
+  return (port->sources[x].buffer - port->sourceBuffer) / DMX_BUFFER_SIZE;
+}
+
+// LTP: take the slots where data differs from the source's last values
+static void artClaimSlots(uint8_t* owner, const uint8_t* data, const uint8_t* last, uint16_t len, uint8_t slot) {
+  uint16_t x = 0;
+
+  // Bytes up to a word boundary
+  for (; x < len && ((uintptr_t)&last[x] & 3); x++) {
+    if (data[x] != last[x])
+      owner[x] = slot;
+  }
+
+  // Then skip 4 unchanged slots at a time if data is aligned too
+  if (((uintptr_t)&data[x] & 3) == 0) {
+    for (; x + 4 <= len; x += 4) {
+      if (*(const uint32_t*)&data[x] == *(const uint32_t*)&last[x])
+        continue;
+
+      for (uint16_t y = x; y < x + 4; y++) {
+        if (data[y] != last[y])
+          owner[y] = slot;
+      }
+    }
+  }
+
+  // Remaining bytes
+  for (; x < len; x++) {
+    if (data[x] != last[x])
+      owner[x] = slot;
+  }
+}
+
+
+// Drop sources we haven't heard from within the timeout.  Returns true if any were dropped
+static bool artExpireSources(port_def* port, unsigned long timeNow) {
+  bool expired = false;
+  uint8_t x = 0;
+
+  while (x < port->numSources) {
+    if ((timeNow - port->sources[x].lastPacketTime) <= port->sourceTimeout) {
+      x++;
+      continue;
+    }
+
+    // Swap with the last source so each buffer stays with a table entry
+    source_def tmp = port->sources[x];
+    port->numSources--;
+    port->sources[x] = port->sources[port->numSources];
+    port->sources[port->numSources] = tmp;
+    expired = true;
+  }
+
+  return expired;
+}
+
+// Where a port is in its source loss policy
+enum loss_state {
+  LOSS_STATE_IDLE = 0,
+  LOSS_STATE_HOLD = 1,
+  LOSS_STATE_FADE = 2
+};
+
+// One fade step: mix from & to by k/65536
+static void artLossMix(uint8_t* dst, const uint8_t* from, const uint8_t* to, uint16_t len, uint32_t k) {
+  uint32_t j = 65536 - k;
+
+  if (to == 0) {
+    for (uint16_t x = 0; x < len; x++)
+      dst[x] = (from[x] * j) >> 16;
+    return;
+  }
+
+  for (uint16_t x = 0; x < len; x++)
+    dst[x] = (from[x] * j + to[x] * k) >> 16;
+}
+
+// Drop all sources of one protocol, keeping the others
+static void artDropSources(port_def* port, uint8_t protocol) {
+  uint8_t x = 0;
+
+  while (x < port->numSources) {
+    if (port->sources[x].protocol != protocol) {
+      x++;
+      continue;
+    }
+
+    source_def tmp = port->sources[x];
+    port->numSources--;
+    port->sources[x] = port->sources[port->numSources];
+    port->sources[port->numSources] = tmp;
+  }
+}
+
+// The protocol whose sources the port's protocol mode ignores right now, or SOURCE_NONE
+static uint8_t artHeldProtocol(port_def* port) {
+  if (port->protocolMode == PROTOCOL_MERGE)
+    return SOURCE_NONE;
+
+  uint8_t wins = (port->protocolMode == PROTOCOL_E131) ? SOURCE_E131 : SOURCE_ARTNET;
+
+  for (uint8_t x = 0; x < port->numSources; x++) {
+    if (port->sources[x].protocol == wins)
+      return (wins == SOURCE_E131) ? SOURCE_ARTNET : SOURCE_E131;
+  }
+
+  return SOURCE_NONE;
+}
+
+// Highest priority of a port's sACN sources, 0 if there are none
+static uint8_t artE131Priority(port_def* port) {
+  uint8_t top = 0;
+
+  for (uint8_t x = 0; x < port->numSources; x++) {
+    if (port->sources[x].protocol == SOURCE_E131 && port->sources[x].priority > top)
+      top = port->sources[x].priority;
+  }
+
+  return top;
+}
+
+// LTP merge: each slot comes from the source that last changed it.  Slots of sources that
+// have gone go to the source we heard from most recently
+static void artMergeLTP(port_def* port, uint16_t start, uint16_t end) {
+  uint8_t held = artHeldProtocol(port);
+  uint8_t active = 0;
+  uint8_t newest = 0;
+
+  // Sources ignored by the protocol mode don't own anything
+  for (uint8_t x = 0; x < port->numSources; x++) {
+    if (port->sources[x].protocol == held)
+      continue;
+
+    active |= (1 << artSourceSlot(port, x));
+
+    if (port->sources[newest].protocol == held || (long)(port->sources[x].lastPacketTime - port->sources[newest].lastPacketTime) > 0)
+      newest = x;
+  }
+
+  newest = artSourceSlot(port, newest);
+
+  for (uint16_t x = start; x < end; x++) {
+    if (!(active & (1 << port->slotOwner[x])))
+      port->slotOwner[x] = newest;
+
+    port->dmxBuffer[x] = port->sourceBuffer[port->slotOwner[x] * DMX_BUFFER_SIZE + x];
+  }
+}
+
+// Merge the source buffers into the output for slots [start, end)
+static void artMergeSources(port_def* port, uint16_t start, uint16_t end) {
+  uint8_t* dst = &port->dmxBuffer[start];
+  uint16_t len = end - start;
+  uint8_t held = artHeldProtocol(port);
+  uint8_t top = 0;
+  bool first = true;
+
+  if (port->mergeMode == MERGE_MODE_LTP) {
+    artMergeLTP(port, start, end);
+    return;
+  }
+
+  // Priority mode only merges the highest priority sources
+  if (port->mergeMode == MERGE_MODE_PRIORITY) {
+    for (uint8_t x = 0; x < port->numSources; x++) {
+      if (port->sources[x].protocol != held && port->sources[x].priority > top)
+        top = port->sources[x].priority;
+    }
+  }
+
+  for (uint8_t x = 0; x < port->numSources; x++) {
+    if (port->sources[x].protocol == held || port->sources[x].priority < top)
+      continue;
+
+    if (first)
+      memcpy(dst, &port->sources[x].buffer[start], len);
+    else
+      artMergeHTP(dst, dst, &port->sources[x].buffer[start], len);
+
+    first = false;
+  }
+}
+
 espArtNetRDM::espArtNetRDM() {
 }
 
@@ -36,11 +317,14 @@ void espArtNetRDM::end() {
       if (_art->group[g]->ports[p]->ownBuffer)
         free(_art->group[g]->ports[p]->dmxBuffer);
 
-      free(_art->group[g]->ports[p]->ipBuffer);
-      free(_art->group[g]->ports[p]);
+      artReleaseSources(_art->group[g]->ports[p]);
+
+      if (_art->group[g]->ports[p]->slot == 0)
+        free(_art->group[g]->ports[p]);
     }
     free(_art->group[g]);
   }
+  free(_art->arena);
   free(_art);
 
   _art = 0;
@@ -71,6 +355,20 @@ void espArtNetRDM::init(IPAddress ip, IPAddress subnet, bool dhcp, const char* s
   _art->syncIP = IPAddress(INADDR_NONE);
   _art->lastSync = 0;
   _art->nextPollReply = 0;
+  _art->nextMergeSweep = 0;
+  _art->nextLossStep = 0;
+  _art->arena = 0;
+  _art->arenaSize = 0;
+  _art->arenaGroups = 0;
+  _art->arenaSources = 0;
+  _art->arenaSpares = 0;
+  _art->firmwareIP = IPAddress(INADDR_NONE);
+  _art->firmwareBlock = 0;
+  _art->firmwareLength = 0;
+  _art->firmwareReceived = 0;
+  _art->firmwareTime = 0;
+  _art->firmwareDone = false;
+  _art->firmwareCallBack = 0;
   memcpy(_art->shortName, shortname, ARTNET_SHORT_NAME_LENGTH);
   memcpy(_art->longName, longname, ARTNET_LONG_NAME_LENGTH);
   memcpy(_art->deviceMAC, mac, 6);
@@ -108,7 +406,7 @@ uint8_t espArtNetRDM::addGroup(uint8_t net, uint8_t subnet) {
   _art->group[g]->netSwitch = net & 0b01111111;
   _art->group[g]->subnet = subnet;
   _art->group[g]->numPorts = 0;
-  _art->group[g]->cancelMergeIP = IPAddress(INADDR_NONE);
+  _art->group[g]->cancelMergeIP = INADDR_NONE;
   _art->group[g]->cancelMerge = 0;
   _art->group[g]->cancelMergeTime = 0;
 
@@ -120,7 +418,7 @@ uint8_t espArtNetRDM::addGroup(uint8_t net, uint8_t subnet) {
   return g;
 }
 
-uint8_t espArtNetRDM::addPort(uint8_t g, uint8_t p, uint8_t universe, uint8_t t, bool htp, uint8_t* buf) {
+uint8_t espArtNetRDM::addPort(uint8_t g, uint8_t p, uint8_t universe, uint8_t t, uint8_t merge, uint8_t* buf) {
   if (_art == 0)
     return 255;
 
@@ -134,14 +432,27 @@ uint8_t espArtNetRDM::addPort(uint8_t g, uint8_t p, uint8_t universe, uint8_t t,
   if (group->ports[p] != 0)
     return p;
 
-  // Allocate space for our port
-  group->ports[p] = (port_def*) malloc(sizeof(port_def));
+  // Use our slot in the arena if begin() made one, otherwise allocate space for our port
+  uint8_t* slot = 0;
+  if (g < _art->arenaGroups)
+    slot = &_art->arena[(g * 4 + p) * artSlotSize(_art->arenaSources)];
+
+  if (slot != 0)
+    group->ports[p] = (port_def*) slot;
+  else
+    group->ports[p] = (port_def*) malloc(sizeof(port_def));
 
   delay(1);
   port_def* port = group->ports[p];
 
+  port->slot = slot;
+  port->slotSources = (slot != 0) ? _art->arenaSources : 0;
+
   // DMX output buffer allocation
-  if (buf == 0) {
+  if (buf == 0 && slot != 0) {
+    port->dmxBuffer = &slot[artPortSize];
+    port->ownBuffer = false;
+  } else if (buf == 0) {
     port->dmxBuffer = (uint8_t*) malloc(DMX_BUFFER_SIZE);
     port->ownBuffer = true;
   } else {
@@ -156,23 +467,44 @@ uint8_t espArtNetRDM::addPort(uint8_t g, uint8_t p, uint8_t universe, uint8_t t,
   // Store settings
   group->numPorts++;
   port->portType = t;
-  port->mergeHTP = htp;
+  port->mergeMode = merge;
   port->portUni = universe;
-  port->senderIP[0] = IPAddress(INADDR_NONE);
-  port->senderIP[1] = IPAddress(INADDR_NONE);
+  port->e131 = false;
+  port->e131Priority = 0;
+  port->protocolMode = PROTOCOL_MERGE;
+  port->outputKnown = false;
+  port->outputActive = false;
 
   for (uint8_t x = 0; x < 5; x++)
     port->rdmSenderIP[x] = IPAddress(INADDR_NONE);
 
-  port->ipBuffer = 0;
-  port->ipChans[0] = 0;
-  port->ipChans[1] = 0;
+  for (uint8_t x = 0; x < ARTNET_MAX_SOURCES; x++)
+    port->sources[x].buffer = 0;
+
+  port->sourceBuffer = 0;
+  port->ownSources = false;
+  port->slotOwner = 0;
+  port->numSources = 0;
+  port->maxSources = ARTNET_DEFAULT_SOURCES;
+  port->sourceTimeout = ARTNET_SOURCE_TIMEOUT;
+  port->lossMode = LOSS_HOLD;
+  port->lossHold = 0;
+  port->lossFade = 0;
+  port->lossScene = 0;
+  port->lossState = LOSS_STATE_IDLE;
+  port->lossTime = 0;
   port->dmxChans = 0;
+  port->changeStart = 0;
+  port->changeEnd = 0;
   port->merging = 0;
+  port->mergeValid = false;
   port->lastTodCommand = 0;
   port->uidTotal = 0;
   port->todAvailable = 0;
 
+  // Merge buffers
+  artAllocSources(port);
+
   return p;
 }
 
@@ -186,13 +518,13 @@ bool espArtNetRDM::closePort(uint8_t g, uint8_t p) {
   if (group->ports[p] == 0)
     return true;
 
-  // Delete buffers
+  // Delete buffers.  Arena slots are kept for the port to be opened again
   if (group->ports[p]->ownBuffer)
     free(group->ports[p]->dmxBuffer);
-  if (group->ports[p]->ipBuffer != 0)
-    free(group->ports[p]->ipBuffer);
+  artReleaseSources(group->ports[p]);
 
-  free(group->ports[p]);
+  if (group->ports[p]->slot == 0)
+    free(group->ports[p]);
 
   // Mark port as empty
   group->ports[p] = 0;
@@ -249,10 +581,21 @@ void espArtNetRDM::setTODFlushCallback(artTodFlushCallBack callback) {
   _art->todFlushCallBack = callback;
 }
 
+void espArtNetRDM::setFirmwareCallback(artFirmwareCallBack callback) {
+  if (_art == 0)
+    return;
+
+  _art->firmwareCallBack = callback;
+}
+
 void espArtNetRDM::begin() {
   if (_art == 0)
     return;
 
+  // Lay out our buffers the first time we start
+  if (_art->arena == 0)
+    _arenaStart();
+
   // Start listening for UDP packets
   eUDP.begin(ARTNET_PORT);
   eUDP.flush();
@@ -263,6 +606,97 @@ void espArtNetRDM::begin() {
   artPollReply();
 }
 
+void espArtNetRDM::_arenaStart() {
+  uint8_t sources = ARTNET_DEFAULT_SOURCES;
+
+  // Make room for the most sources any port is set up for
+  for (uint8_t g = 0; g < _art->numGroups; g++) {
+    for (uint8_t p = 0; p < 4; p++) {
+      if (_art->group[g]->ports[p] != 0 && _art->group[g]->ports[p]->maxSources > sources)
+        sources = _art->group[g]->ports[p]->maxSources;
+    }
+  }
+
+  // A slot for all 4 ports of each group so ports can be opened & closed later without touching the heap
+  uint32_t slotSize = artSlotSize(sources);
+  uint32_t size = _art->numGroups * 4 * slotSize + _art->arenaSpares * DMX_BUFFER_SIZE;
+
+  // Not enough memory - keep using separate allocations
+  uint8_t* arena = (uint8_t*) malloc(size);
+  if (arena == 0)
+    return;
+
+  delay(0);
+  memset(arena, 0, size);
+  delay(0);
+
+  // Move the ports we already have into their slots
+  for (uint8_t g = 0; g < _art->numGroups; g++) {
+    for (uint8_t p = 0; p < 4; p++) {
+      port_def* old = _art->group[g]->ports[p];
+
+      if (old == 0)
+        continue;
+
+      uint8_t* slot = &arena[(g * 4 + p) * slotSize];
+      port_def* port = (port_def*) slot;
+
+      memcpy(port, old, sizeof(port_def));
+      port->slot = slot;
+      port->slotSources = sources;
+
+      if (old->ownBuffer) {
+        port->dmxBuffer = &slot[artPortSize];
+        memcpy(port->dmxBuffer, old->dmxBuffer, DMX_BUFFER_SIZE);
+        free(old->dmxBuffer);
+        port->ownBuffer = false;
+      }
+
+      // Bring the source buffers along so merging carries on where it left off
+      if (old->sourceBuffer != 0) {
+        uint8_t* pool = &slot[artPortSize + DMX_BUFFER_SIZE];
+        memcpy(pool, old->sourceBuffer, (old->maxSources + 1) * DMX_BUFFER_SIZE);
+
+        for (uint8_t x = 0; x < ARTNET_MAX_SOURCES; x++) {
+          if (old->sources[x].buffer != 0)
+            port->sources[x].buffer = pool + (old->sources[x].buffer - old->sourceBuffer);
+        }
+
+        if (old->ownSources)
+          free(old->sourceBuffer);
+
+        port->sourceBuffer = pool;
+        port->ownSources = false;
+        port->slotOwner = &pool[port->maxSources * DMX_BUFFER_SIZE];
+      } else {
+        artAllocSources(port);
+      }
+
+      free(old);
+      _art->group[g]->ports[p] = port;
+    }
+  }
+
+  _art->arena = arena;
+  _art->arenaSize = size;
+  _art->arenaGroups = _art->numGroups;
+  _art->arenaSources = sources;
+}
+
+void espArtNetRDM::reserveBuffers(uint8_t n) {
+  if (_art == 0 || _art->arena != 0)
+    return;
+
+  _art->arenaSpares = n;
+}
+
+uint8_t* espArtNetRDM::getSpareBuffer(uint8_t n) {
+  if (_art == 0 || _art->arena == 0 || n >= _art->arenaSpares)
+    return NULL;
+
+  return &_art->arena[_art->arenaGroups * 4 * artSlotSize(_art->arenaSources) + n * DMX_BUFFER_SIZE];
+}
+
 void espArtNetRDM::pause() {
   if (_art == 0)
     return;
@@ -279,7 +713,13 @@ void espArtNetRDM::handler() {
 
   if (packetSize > 0) {
 
-    unsigned char _artBuffer[ARTNET_BUFFER_MAX];
+    // Offset by 2 so the ArtDMX slots (at byte 18) start on a word boundary
+    uint32_t _artSpace[(ARTNET_BUFFER_MAX + 2 + 3) / 4];
+    unsigned char* _artBuffer = (unsigned char*)_artSpace + 2;
+
+    // Anything longer than our largest packet type is truncated
+    if (packetSize > ARTNET_BUFFER_MAX)
+      packetSize = ARTNET_BUFFER_MAX;
 
     // Read data into buffer
     eUDP.read(_artBuffer, packetSize);
@@ -311,7 +751,7 @@ void espArtNetRDM::handler() {
         break;
 
       case ARTNET_FIRMWARE_MASTER:
-        _artFirmwareMaster(_artBuffer);
+        _artFirmwareMaster(_artBuffer, packetSize);
         break;
 
       case ARTNET_TOD_REQUEST:
@@ -338,14 +778,29 @@ void espArtNetRDM::handler() {
 
   if (packetSize > 0) {
 
-    e131_packet_t _e131Buffer;
+    // Offset by 2 so the sACN slots (at byte 126) start on a word boundary
+    uint32_t _e131Space[(sizeof(e131_packet_t) + 2 + 3) / 4];
+    e131_packet_t* _e131Buffer = (e131_packet_t*)((uint8_t*)_e131Space + 2);
+
+    if (packetSize > E131_BUFFER_MAX)
+      packetSize = E131_BUFFER_MAX;
 
     // Read data into buffer
-    fUDP.readBytes(_e131Buffer.raw, packetSize);
+    fUDP.readBytes(_e131Buffer->raw, packetSize);
 
-    _e131Receive(&_e131Buffer);
+    _e131Receive(_e131Buffer);
   }
 
+  // Time out merge sources & cancel merge
+  _mergeSweep();
+
+  // Fade ports that have lost all their sources
+  _lossStep();
+
+  // Abandon firmware uploads that have stalled
+  if (_art->firmwareLength != 0 && (_art->firmwareTime + ARTNET_FIRMWARE_TIMEOUT) < millis())
+    _artFirmwareAbort();
+
   // Send artPollReply - the function will limit the number sent
   _artPoll();
 
@@ -496,11 +951,11 @@ void espArtNetRDM::_artPoll() {
 
         // Get values for Good Output field
         uint8_t go = 0;
-        if (group->ports[x]->dmxChans != 0)
+        if (group->ports[x]->outputKnown ? group->ports[x]->outputActive : group->ports[x]->dmxChans != 0)
           go |= 128;						// data being transmitted
         if (group->ports[x]->merging)
           go |= 8;						// artnet data being merged
-        if (! group->ports[x]->mergeHTP)
+        if (group->ports[x]->mergeMode == MERGE_MODE_LTP)
           go |= 2;						// Merge mode LTP
         if (group->ports[x]->e131)
           go |= 1;						// sACN
@@ -541,11 +996,12 @@ void espArtNetRDM::artPollReply() {
 void espArtNetRDM::_artDMX(unsigned char *_artBuffer) {
   group_def* group = 0;
 
-  IPAddress rIP = eUDP.remoteIP();
+  uint32_t rIP = eUDP.remoteIP();
+  unsigned long timeNow = millis();
 
 #ifdef IP_PROTO_DEBUG
   Serial.print("espArtNetRDM::_artDMX, IP:");
-  Serial.println(rIP);
+  Serial.println(IPAddress(rIP));
 #endif
 
   uint8_t net = (_artBuffer[15] & 0x7F);
@@ -568,17 +1024,17 @@ void espArtNetRDM::_artDMX(unsigned char *_artBuffer) {
 
         // If this port has the correct Net, Sub & Uni then save DMX to buffer
         if (uni == group->ports[y]->portUni)
-          _saveDMX(&_artBuffer[ARTNET_ADDRESS_OFFSET], numberOfChannels, x, y, rIP, startChannel);
+          _saveDMX(&_artBuffer[ARTNET_ADDRESS_OFFSET], numberOfChannels, x, y, rIP, SOURCE_ARTNET, startChannel, ARTNET_DEFAULT_PRIORITY, timeNow);
       }
     }
   }
 }
 
-void espArtNetRDM::_saveDMX(unsigned char *dmxData, uint16_t numberOfChannels, uint8_t groupNum, uint8_t portNum, IPAddress rIP, uint16_t startChannel) {
+void espArtNetRDM::_saveDMX(unsigned char *dmxData, uint16_t numberOfChannels, uint8_t groupNum, uint8_t portNum, uint32_t rIP, uint8_t protocol, uint16_t startChannel, uint8_t priority, unsigned long timeNow) {
 
 #ifdef IP_PROTO_DEBUG
   Serial.print("espArtNetRDM::_saveDMX, IP:");
-  Serial.println(rIP);
+  Serial.println(IPAddress(rIP));
   Serial.printf("Number of Channels %u, Group %u, Port &u, Start Chan &u", numberOfChannels, groupNum, portNum, startChannel);
 #endif
 
@@ -586,107 +1042,185 @@ void espArtNetRDM::_saveDMX(unsigned char *dmxData, uint16_t numberOfChannels, u
   group_def* group = _art->group[groupNum];
   port_def* port = group->ports[portNum];
 
-  uint8_t senderID = 255;  // Will be set to 0 or 1 if valid later
+  bool fullMerge = false;
+  bool newSource = false;
 
-  unsigned long timeNow = millis();
+  // This is the correct IP, enable cancel merge (old cancel merges are cleared in _mergeSweep)
+  if (protocol == SOURCE_ARTNET && group->cancelMergeIP == rIP) {
+    group->cancelMerge = 1;
+    group->cancelMergeTime = timeNow;
+    port->mergeMode = MERGE_MODE_LTP;
 
-  // We can't do the next calculations until after 10 seconds
-  if (timeNow > 10000) {
-    unsigned long timeExp = timeNow - 10000;
+    // If the merge is current & IP isn't correct, ignore this packet before it can take a source slot
+  } else if (group->cancelMerge)
+    return;
 
-    // Clear IPs that we haven't heard from in over 10 seconds
-    if (port->lastPacketTime[0] < timeExp)
-      port->senderIP[0] = IPAddress(INADDR_NONE);
-    else if (port->lastPacketTime[1] < timeExp)
-      port->senderIP[1] = IPAddress(INADDR_NONE);
-  }
+  // A higher sACN priority takes over from the sACN sources we have (priority mode merges them instead)
+  if (protocol == SOURCE_E131 && port->mergeMode != MERGE_MODE_PRIORITY && priority > port->e131Priority) {
+    artDropSources(port, SOURCE_E131);
 
-  // Get a sender ID
-  if (port->senderIP[0] == rIP) {
-    senderID = 0;
-    port->lastPacketTime[0] = timeNow;
-  } else if (port->senderIP[1] == rIP || port->senderIP[1] == IPAddress(INADDR_NONE)) {
-    senderID = 1;
-    port->senderIP[1] = rIP;
-    port->lastPacketTime[1] = timeNow;
-  } else if (port->senderIP[0] == IPAddress(INADDR_NONE)) {
-    senderID = 0;
-    port->senderIP[0] = rIP;
-    port->lastPacketTime[0] = timeNow;
+    // Nothing left to merge with - start from a clear buffer.  Any Artnet sources stay, & the output
+    // still holds their data for the merge that follows
+    if (port->numSources == 0) {
+      artClearDMXBuffer(port->dmxBuffer);
+      port->mergeValid = false;
+    }
+
+    fullMerge = true;
   }
 
-  // This is a third IP so drop the packet (Artnet v4 only allows for merging 2 DMX streams)
-  if (senderID == 255)
-    return;
+  // Find this sender in our sources.  The same IP can send both protocols
+  uint8_t s = 0;
+  while (s < port->numSources && (port->sources[s].ip != rIP || port->sources[s].protocol != protocol))
+    s++;
 
-  // Check if we're merging (the other IP will be non zero)
-  if (port->senderIP[(senderID ^ 0x01)] == IPAddress(INADDR_NONE))
-    port->merging = false;
-  else
-    port->merging = true;
+  if (s == port->numSources) {
+    // All source slots are in use.  A source that has timed out but not been swept yet makes way,
+    // otherwise drop the packet (Artnet v4 only allows for merging 2 DMX streams)
+    if (s >= port->maxSources) {
+      if (!artExpireSources(port, timeNow))
+        return;
+
+      port->e131Priority = artE131Priority(port);
+      s = port->numSources;
+      fullMerge = true;
+    }
 
+    port->sources[s].ip = rIP;
+    port->sources[s].protocol = protocol;
+    port->sources[s].priority = priority;
+    port->numSources++;
+    newSource = true;
 
-  // Cancel merge is old so cancel the cancel merge
-  if ((group->cancelMergeTime + ARTNET_CANCEL_MERGE_TIMEOUT) < millis()) {
-    group->cancelMerge = false;
-    group->cancelMergeIP = IPAddress(INADDR_NONE);
+    if (port->sources[s].buffer != 0)
+      artClearDMXBuffer(port->sources[s].buffer);
 
-  } else {
-    // This is the correct IP, enable cancel merge
-    if (group->cancelMergeIP == port->senderIP[senderID]) {
-      group->cancelMerge = 1;
-      group->cancelMergeTime = millis();
-      port->mergeHTP = false;
-      port->merging = false;
-
-      // If the merge is current & IP isn't correct, ignore this packet
-    } else if (group->cancelMerge)
-      return;
+    // A new source can take over in priority mode or from the other protocol
+    if (port->mergeMode == MERGE_MODE_PRIORITY || port->protocolMode != PROTOCOL_MERGE)
+      fullMerge = true;
   }
 
+  source_def* source = &port->sources[s];
+  source->lastPacketTime = timeNow;
+
+  // Any data stops the loss policy - the first source buffer might be about to be used again
+  port->lossState = LOSS_STATE_IDLE;
+
+  if (source->priority != priority) {
+    source->priority = priority;
+
+    if (port->mergeMode == MERGE_MODE_PRIORITY)
+      fullMerge = true;
+  }
+
+  // Check if we're merging (more than 1 source).  Cancel merge outputs its one sender alone
+  port->merging = (port->numSources > 1 && !group->cancelMerge);
+
   // Store number of channels
-  if (numberOfChannels > port->dmxChans)
+  bool grown = false;
+
+  if (startChannel >= DMX_BUFFER_SIZE)
+    return;
+  if (startChannel + numberOfChannels > DMX_BUFFER_SIZE)
+    numberOfChannels = DMX_BUFFER_SIZE - startChannel;
+
+  if (numberOfChannels > port->dmxChans) {
     port->dmxChans = numberOfChannels;
+    grown = true;
+  }
 
-  // Check if we should merge (HTP) or not merge (LTP)
-  if (port->merging && port->mergeHTP) {
-    // Check if there is a buffer.  If not, allocate and clear it
-    if (port->ipBuffer == 0) {
+  uint16_t changeStart = 0;
+  uint16_t changeEnd = 0;
 
-      port->ipBuffer = (uint8_t*) malloc(2 * DMX_BUFFER_SIZE);
-      delay(0);
-      artClearDMXBuffer(port->ipBuffer);
-      artClearDMXBuffer(&port->ipBuffer[DMX_BUFFER_SIZE]);
-      delay(0);
+  // Merge if we have more than 1 source.  No source buffers means the allocation failed
+  if (port->merging && port->sourceBuffer != 0) {
+    uint8_t* sourceBuf = source->buffer;
+
+    if (!port->mergeValid) {
+      // Merge just started - the other senders' data is what we're currently outputting
+      uint8_t owner = artSourceSlot(port, s);
+
+      for (uint8_t x = 0; x < port->numSources; x++) {
+        if (x == s && newSource)
+          continue;
+
+        memcpy(port->sources[x].buffer, port->dmxBuffer, DMX_BUFFER_SIZE);
+
+        if (newSource)
+          owner = artSourceSlot(port, x);
+      }
+
+      // LTP: the slots belong to whoever we were outputting
+      memset(port->slotOwner, owner, DMX_BUFFER_SIZE);
+      fullMerge = true;
+    }
+
+    // Put the changed data into this sender's buffer
+    if (artChangedRange(dmxData, &sourceBuf[startChannel], numberOfChannels, &changeStart, &changeEnd)) {
+      changeStart += startChannel;
+      changeEnd += startChannel;
+
+      // LTP: this sender now owns the slots it changed
+      if (port->mergeMode == MERGE_MODE_LTP)
+        artClaimSlots(&port->slotOwner[changeStart], &dmxData[changeStart - startChannel], &sourceBuf[changeStart], changeEnd - changeStart, artSourceSlot(port, s));
+
+      memcpy(&sourceBuf[changeStart], &dmxData[changeStart - startChannel], changeEnd - changeStart);
+    }
+
+    if (fullMerge) {
+      changeStart = 0;
+      changeEnd = port->dmxChans;
+
+      // Data from a protocol that's being ignored doesn't change the output
+    } else if (artHeldProtocol(port) == protocol) {
+      changeStart = 0;
+      changeEnd = 0;
     }
 
-    // Put data into our buffer
-    memcpy(&port->ipBuffer[senderID * DMX_BUFFER_SIZE + startChannel], dmxData, numberOfChannels);
+    // Only the slots this sender changed need merging again
+    if (changeStart != changeEnd)
+      artMergeSources(port, changeStart, changeEnd);
 
-    // Get the number of channels to compare
-    numberOfChannels = (port->dmxChans > numberOfChannels) ? port->dmxChans : numberOfChannels;
+    port->mergeValid = true;
+    port->changeStart = changeStart;
+    port->changeEnd = changeEnd;
 
-    // Compare data and put in the output buffer
-    for (uint16_t x = 0; x < numberOfChannels; x++)
-      port->dmxBuffer[x] = (port->ipBuffer[x] > port->ipBuffer[x + DMX_BUFFER_SIZE]) ? port->ipBuffer[x] : port->ipBuffer[x + DMX_BUFFER_SIZE];
+    // Nothing new for the outputs
+    if (changeStart == changeEnd && !grown)
+      return;
 
     // Call our dmx callback in the main script (Sync doesn't get used when merging)
-    _art->dmxCallBack(groupNum, portNum, numberOfChannels, false);
+    _art->dmxCallBack(groupNum, portNum, port->dmxChans, false);
 
   } else {
-    // Copy data directly into output buffer
-    memcpy(&port->dmxBuffer[startChannel], dmxData, numberOfChannels);
-
-    /*
-        // Delete merge buffer if it exists
-        if (port->ipBuffer != 0) {
-          free(port->ipBuffer);
-          port->ipBuffer = 0;
-        }
-    */
+    port->mergeValid = false;
+
+    // Data from a protocol that's being ignored doesn't change the output
+    if (artHeldProtocol(port) == protocol)
+      return;
+
+    // Copy changed data directly into output buffer
+    if (artChangedRange(dmxData, &port->dmxBuffer[startChannel], numberOfChannels, &changeStart, &changeEnd)) {
+      memcpy(&port->dmxBuffer[startChannel + changeStart], &dmxData[changeStart], changeEnd - changeStart);
+      changeStart += startChannel;
+      changeEnd += startChannel;
+    }
+
+    // Buffer was cleared for a new sACN priority
+    if (fullMerge) {
+      changeStart = 0;
+      changeEnd = port->dmxChans;
+    }
+
+    port->changeStart = changeStart;
+    port->changeEnd = changeEnd;
+
+    // Nothing new for the outputs
+    if (changeStart == changeEnd && !grown)
+      return;
 
     // Check if Sync is enabled and call dmx callback in the main script
-    if (_art->lastSync == 0 || (_art->lastSync + 4000) < timeNow || _art->syncIP != rIP)
+    if (_art->lastSync == 0 || (_art->lastSync + 4000) < timeNow || (uint32_t)_art->syncIP != rIP)
       _art->dmxCallBack(groupNum, portNum, numberOfChannels, false);
     else
       _art->dmxCallBack(groupNum, portNum, numberOfChannels, true);
@@ -695,6 +1229,113 @@ void espArtNetRDM::_saveDMX(unsigned char *dmxData, uint16_t numberOfChannels, u
   }
 }
 
+void espArtNetRDM::_mergeSweep() {
+  unsigned long timeNow = millis();
+
+  if ((long)(timeNow - _art->nextMergeSweep) < 0)
+    return;
+
+  _art->nextMergeSweep = timeNow + ARTNET_MERGE_SWEEP_INTERVAL;
+
+  for (uint8_t g = 0; g < _art->numGroups; g++) {
+    group_def* group = _art->group[g];
+
+    // Cancel merge is old so cancel the cancel merge
+    if (group->cancelMergeIP != INADDR_NONE && (group->cancelMergeTime + ARTNET_CANCEL_MERGE_TIMEOUT) < timeNow) {
+      group->cancelMerge = false;
+      group->cancelMergeIP = INADDR_NONE;
+    }
+
+    for (uint8_t p = 0; p < 4; p++) {
+      port_def* port = group->ports[p];
+
+      // Drop sources we haven't heard from in a while
+      if (port == 0 || !artExpireSources(port, timeNow))
+        continue;
+
+      port->merging = (port->numSources > 1);
+
+      // Lower sACN priorities are allowed in again once the higher ones have gone
+      port->e131Priority = artE131Priority(port);
+
+      // Everyone's gone: hold the last look until the loss policy says otherwise
+      if (port->numSources == 0 && port->lossMode != LOSS_HOLD) {
+        port->lossState = LOSS_STATE_HOLD;
+        port->lossTime = timeNow;
+      }
+
+      // Merge the rest again and update the outputs
+      if (!port->mergeValid || port->numSources == 0)
+        continue;
+
+      artMergeSources(port, 0, port->dmxChans);
+
+      port->changeStart = 0;
+      port->changeEnd = port->dmxChans;
+
+      if (_art->dmxCallBack != 0)
+        _art->dmxCallBack(g, p, port->dmxChans, false);
+    }
+  }
+}
+
+void espArtNetRDM::_lossStep() {
+  unsigned long timeNow = millis();
+
+  if ((long)(timeNow - _art->nextLossStep) < 0)
+    return;
+
+  _art->nextLossStep = timeNow + ARTNET_LOSS_STEP_INTERVAL;
+
+  for (uint8_t g = 0; g < _art->numGroups; g++) {
+    for (uint8_t p = 0; p < 4; p++) {
+      port_def* port = _art->group[g]->ports[p];
+
+      if (port == 0 || port->lossState == LOSS_STATE_IDLE)
+        continue;
+
+      unsigned long elapsed = timeNow - port->lossTime;
+
+      // Still holding.  Without a source buffer to fade from we hold forever
+      if (port->lossState == LOSS_STATE_HOLD) {
+        if (elapsed < port->lossHold)
+          continue;
+
+        if (port->sourceBuffer == 0) {
+          port->lossState = LOSS_STATE_IDLE;
+          continue;
+        }
+
+        memcpy(port->sources[0].buffer, port->dmxBuffer, DMX_BUFFER_SIZE);
+        port->mergeValid = false;
+        port->lossState = LOSS_STATE_FADE;
+        port->lossTime += port->lossHold;
+        elapsed -= port->lossHold;
+
+        // A scene covers the whole universe
+        if (port->lossMode == LOSS_FADE_SCENE && port->lossScene != 0)
+          port->dmxChans = DMX_BUFFER_SIZE;
+      }
+
+      uint8_t* to = (port->lossMode == LOSS_FADE_SCENE) ? port->lossScene : 0;
+      uint32_t k = 65536;
+
+      if (elapsed < port->lossFade)
+        k = ((uint64_t)elapsed << 16) / port->lossFade;
+      else
+        port->lossState = LOSS_STATE_IDLE;
+
+      artLossMix(port->dmxBuffer, port->sources[0].buffer, to, port->dmxChans, k);
+
+      port->changeStart = 0;
+      port->changeEnd = port->dmxChans;
+
+      if (_art->dmxCallBack != 0)
+        _art->dmxCallBack(g, p, port->dmxChans, false);
+    }
+  }
+}
+
 uint8_t* espArtNetRDM::getDMX(uint8_t g, uint8_t p) {
   if (_art == 0)
     return NULL;
@@ -706,6 +1347,30 @@ uint8_t* espArtNetRDM::getDMX(uint8_t g, uint8_t p) {
   return NULL;
 }
 
+// Bytes of heap used for DMX output and merge buffers
+uint32_t espArtNetRDM::getBufferBytes() {
+  if (_art == 0)
+    return 0;
+
+  uint32_t bytes = _art->arenaSize;
+
+  for (uint8_t g = 0; g < _art->numGroups; g++) {
+    for (uint8_t p = 0; p < 4; p++) {
+      port_def* port = _art->group[g]->ports[p];
+
+      if (port == 0)
+        continue;
+
+      if (port->ownBuffer)
+        bytes += DMX_BUFFER_SIZE;
+      if (port->ownSources)
+        bytes += (port->maxSources + 1) * DMX_BUFFER_SIZE;
+    }
+  }
+
+  return bytes;
+}
+
 uint16_t espArtNetRDM::numChans(uint8_t g, uint8_t p) {
   if (_art == 0)
     return 0;
@@ -717,6 +1382,16 @@ uint16_t espArtNetRDM::numChans(uint8_t g, uint8_t p) {
   return 0;
 }
 
+bool espArtNetRDM::getChanged(uint8_t g, uint8_t p, uint16_t* start, uint16_t* end) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return false;
+
+  *start = _art->group[g]->ports[p]->changeStart;
+  *end = _art->group[g]->ports[p]->changeEnd;
+
+  return (*start < *end);
+}
+
 void espArtNetRDM::_artIPProg(unsigned char *_artBuffer) {
   // Don't do anything if it's the same command again
   if ((_art->lastIPProg + 20) > millis())
@@ -842,22 +1517,15 @@ void espArtNetRDM::_artAddress(unsigned char *_artBuffer) {
   switch (_artBuffer[106]) {
     case ARTNET_AC_CANCEL_MERGE:
       _art->group[g]->cancelMergeTime = millis();
-      _art->group[g]->cancelMergeIP = eUDP.remoteIP();
+      _art->group[g]->cancelMergeIP = (uint32_t)eUDP.remoteIP();
 
       /*
         for (int x = 0; x < 4; x++) {
         if (_art->group[g]->ports[x] == 0)
           continue;
 
-        // Delete merge buffer if it exists
-        if (_art->group[g]->ports[x]->ipBuffer != 0) {
-          free(_art->group[g]->ports[x]->ipBuffer);
-          _art->group[g]->ports[x]->ipBuffer = 0;
-        }
-
-        // Update our timer variables
-        _art->group[g]->ports[x]->lastPacketTime[0] = 0;
-        _art->group[g]->ports[x]->lastPacketTime[1] = 0;
+        // Delete merge buffers and sources
+        artReleaseSources(_art->group[g]->ports[x]);
         }
       */
       break;
@@ -867,22 +1535,12 @@ void espArtNetRDM::_artAddress(unsigned char *_artBuffer) {
     case ARTNET_AC_MERGE_LTP_2:
     case ARTNET_AC_MERGE_LTP_3:
       if (_art->group[g]->ports[p] != 0) {
-        // Delete merge buffer if it exists
-        if (_art->group[g]->ports[p]->ipBuffer != 0) {
-          free(_art->group[g]->ports[p]->ipBuffer);
-          _art->group[g]->ports[p]->ipBuffer = 0;
-        }
-
-        // Update our timer variables
-        _art->group[g]->ports[p]->lastPacketTime[0] = 0;
-        _art->group[g]->ports[p]->lastPacketTime[1] = 0;
-
         // Set to LTP
-        _art->group[g]->ports[p]->mergeHTP = false;
+        setMergeMode(g, p, MERGE_MODE_LTP);
 
         // Cancel the cancel merge
         _art->group[g]->cancelMerge = 0;
-        _art->group[g]->cancelMergeIP = IPAddress(INADDR_NONE);
+        _art->group[g]->cancelMergeIP = INADDR_NONE;
       }
       break;
 
@@ -892,11 +1550,11 @@ void espArtNetRDM::_artAddress(unsigned char *_artBuffer) {
     case ARTNET_AC_MERGE_HTP_3:
       // Set to HTP
       if (_art->group[g]->ports[p] != 0) {
-        _art->group[g]->ports[p]->mergeHTP = true;
+        setMergeMode(g, p, MERGE_MODE_HTP);
 
         // Cancel the cancel merge
         _art->group[g]->cancelMerge = 0;
-        _art->group[g]->cancelMergeIP = IPAddress(INADDR_NONE);
+        _art->group[g]->cancelMergeIP = INADDR_NONE;
       }
       break;
 
@@ -905,11 +1563,8 @@ void espArtNetRDM::_artAddress(unsigned char *_artBuffer) {
     case ARTNET_AC_CLEAR_OP_2:
     case ARTNET_AC_CLEAR_OP_3:
       if (_art->group[g]->ports[p] == 0) {
-        // Delete merge buffer if it exists
-        if (_art->group[g]->ports[p]->ipBuffer != 0) {
-          free(_art->group[g]->ports[p]->ipBuffer);
-          _art->group[g]->ports[p]->ipBuffer = 0;
-        }
+        // Delete merge buffers and sources
+        artReleaseSources(_art->group[g]->ports[p]);
 
         // Clear the DMX output buffer
         artClearDMXBuffer(_art->group[g]->ports[p]->dmxBuffer);
@@ -956,8 +1611,123 @@ void espArtNetRDM::_artSync(unsigned char *_artBuffer) {
     _art->syncCallBack();
 }
 
-void espArtNetRDM::_artFirmwareMaster(unsigned char *_artBuffer) {
-  //Serial.println("artFirmwareMaster");
+void espArtNetRDM::_artFirmwareMaster(unsigned char *_artBuffer, uint16_t packetSize) {
+  IPAddress rIP = eUDP.remoteIP();
+
+  uint8_t type = _artBuffer[14];
+  uint8_t block = _artBuffer[15];
+
+  // UBEA uploads aren't supported
+  if (_art->firmwareCallBack == 0 || type > ARTNET_FIRM_LAST || packetSize < ARTNET_FIRMWARE_HEADER_SIZE) {
+    _artFirmwareReply(rIP, ARTNET_FIRM_FAIL);
+    return;
+  }
+
+  if (type == ARTNET_FIRM_FIRST) {
+    // A new upload replaces any unfinished one - even a restart from the same controller
+    if (_art->firmwareLength != 0)
+      _artFirmwareAbort();
+
+    // Firmware length is given in 16 bit words, hi byte first
+    uint32_t words = ((uint32_t)_artBuffer[16] << 24) | ((uint32_t)_artBuffer[17] << 16) | (_artBuffer[18] << 8) | _artBuffer[19];
+
+    _art->firmwareIP = rIP;
+    _art->firmwareBlock = 0;
+    _art->firmwareLength = words * 2;
+    _art->firmwareReceived = 0;
+    _art->firmwareDone = false;
+
+  } else {
+    // Our last reply was lost and the block has been resent - acknowledge it again.  Block IDs
+    // wrap at 256 so the previous one is compared modulo 256
+    if (_art->firmwareIP == rIP && _art->firmwareReceived != 0 && block == (uint8_t)(_art->firmwareBlock - 1)) {
+      if (_art->firmwareLength != 0) {
+        _artFirmwareReply(rIP, ARTNET_FIRM_BLOCK_GOOD);
+        return;
+      }
+      if (_art->firmwareDone && type == ARTNET_FIRM_LAST) {
+        _artFirmwareReply(rIP, ARTNET_FIRM_ALL_GOOD);
+        return;
+      }
+    }
+
+    // Only one controller can upload at a time and blocks must arrive in order
+    if (_art->firmwareLength == 0 || _art->firmwareIP != rIP) {
+      _artFirmwareReply(rIP, ARTNET_FIRM_FAIL);
+      return;
+    }
+  }
+
+  if (block != _art->firmwareBlock || _art->firmwareLength == 0) {
+    _artFirmwareAbort();
+    _artFirmwareReply(rIP, ARTNET_FIRM_FAIL);
+    return;
+  }
+
+  // The last block can be short
+  uint16_t len = packetSize - ARTNET_FIRMWARE_HEADER_SIZE;
+  if (len > ARTNET_FIRMWARE_BLOCK_SIZE)
+    len = ARTNET_FIRMWARE_BLOCK_SIZE;
+  if (len > _art->firmwareLength - _art->firmwareReceived)
+    len = _art->firmwareLength - _art->firmwareReceived;
+
+  // Stream the block straight into flash
+  if (!_art->firmwareCallBack(type, &_artBuffer[ARTNET_FIRMWARE_HEADER_SIZE], len, _art->firmwareLength)) {
+    _art->firmwareLength = 0;
+    _artFirmwareReply(rIP, ARTNET_FIRM_FAIL);
+    return;
+  }
+
+  _art->firmwareReceived += len;
+  _art->firmwareBlock++;
+  _art->firmwareTime = millis();
+
+  if (type == ARTNET_FIRM_LAST) {
+    _art->firmwareLength = 0;
+    _art->firmwareDone = true;
+    _artFirmwareReply(rIP, ARTNET_FIRM_ALL_GOOD);
+  } else {
+    // The controller waits for this before sending the next block
+    _artFirmwareReply(rIP, ARTNET_FIRM_BLOCK_GOOD);
+  }
+}
+
+void espArtNetRDM::_artFirmwareAbort() {
+  _art->firmwareLength = 0;
+  _art->firmwareDone = false;
+
+  // Let the main script discard the partial image
+  if (_art->firmwareCallBack != 0)
+    _art->firmwareCallBack(ARTNET_FIRM_FAIL, NULL, 0, 0);
+}
+
+void espArtNetRDM::_artFirmwareReply(IPAddress ip, uint8_t code) {
+  // Initialise our reply
+  char firmwareReply[ARTNET_FIRMWARE_REPLY_SIZE];
+
+  firmwareReply[0] = 'A';
+  firmwareReply[1] = 'r';
+  firmwareReply[2] = 't';
+  firmwareReply[3] = '-';
+  firmwareReply[4] = 'N';
+  firmwareReply[5] = 'e';
+  firmwareReply[6] = 't';
+  firmwareReply[7] = 0;
+  firmwareReply[8] = uint8_t(ARTNET_FIRMWARE_REPLY);      // op code lo-hi
+  firmwareReply[9] = uint8_t(ARTNET_FIRMWARE_REPLY >> 8);
+  firmwareReply[10] = 0;
+  firmwareReply[11] = 14;                 // artNet version (14)
+  firmwareReply[12] = 0;
+  firmwareReply[13] = 0;
+  firmwareReply[14] = code;
+
+  for (uint8_t x = 15; x < ARTNET_FIRMWARE_REPLY_SIZE; x++)
+    firmwareReply[x] = 0;
+
+  // Send packet
+  eUDP.beginPacket(ip, ARTNET_PORT);
+  eUDP.write((const uint8_t *)firmwareReply, ARTNET_FIRMWARE_REPLY_SIZE);
+  eUDP.endPacket();
 }
 
 void espArtNetRDM::_artTODRequest(unsigned char *_artBuffer) {
@@ -1273,18 +2043,101 @@ void espArtNetRDM:: setPortType(uint8_t g, uint8_t p, uint8_t t) {
     return;
 
   _art->group[g]->ports[p]->portType = t;
+
+  // DMX in ports don't need merge buffers
+  artAllocSources(_art->group[g]->ports[p]);
 }
 
 void espArtNetRDM::setMerge(uint8_t g, uint8_t p, bool htp) {
+  setMergeMode(g, p, htp ? MERGE_MODE_HTP : MERGE_MODE_LTP);
+}
+
+bool espArtNetRDM::getMerge(uint8_t g, uint8_t p) {
   if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return 0;
+  return (_art->group[g]->ports[p]->mergeMode != MERGE_MODE_LTP);
+}
+
+void espArtNetRDM::setMergeMode(uint8_t g, uint8_t p, uint8_t mode) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return;
+
+  if (_art->group[g]->ports[p]->mergeMode == mode)
     return;
-  _art->group[g]->ports[p]->mergeHTP = htp;
+
+  // Merge again from the output buffer on the next packet
+  _art->group[g]->ports[p]->mergeMode = mode;
+  _art->group[g]->ports[p]->mergeValid = false;
+
+  artAllocSources(_art->group[g]->ports[p]);
 }
 
-bool espArtNetRDM::getMerge(uint8_t g, uint8_t p) {
+uint8_t espArtNetRDM::getMergeMode(uint8_t g, uint8_t p) {
   if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
     return 0;
-  return _art->group[g]->ports[p]->mergeHTP;
+  return _art->group[g]->ports[p]->mergeMode;
+}
+
+void espArtNetRDM::setOutputStatus(uint8_t g, uint8_t p, bool active) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return;
+
+  port_def* port = _art->group[g]->ports[p];
+
+  port->outputKnown = true;
+  port->outputActive = active;
+}
+
+void espArtNetRDM::setMaxSources(uint8_t g, uint8_t p, uint8_t n) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return;
+
+  if (n == 0)
+    n = 1;
+  else if (n > ARTNET_MAX_SOURCES)
+    n = ARTNET_MAX_SOURCES;
+
+  if (_art->group[g]->ports[p]->maxSources == n)
+    return;
+
+  // The buffers are sized for the number of sources so start again
+  artReleaseSources(_art->group[g]->ports[p]);
+  _art->group[g]->ports[p]->maxSources = n;
+  artAllocSources(_art->group[g]->ports[p]);
+}
+
+uint8_t espArtNetRDM::getMaxSources(uint8_t g, uint8_t p) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return 0;
+  return _art->group[g]->ports[p]->maxSources;
+}
+
+void espArtNetRDM::setSourceTimeout(uint8_t g, uint8_t p, unsigned long t) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return;
+  _art->group[g]->ports[p]->sourceTimeout = t;
+}
+
+// What to output once all sources have timed out: hold the last look, or hold for hold ms then fade over fade ms
+void espArtNetRDM::setLossPolicy(uint8_t g, uint8_t p, uint8_t mode, unsigned long hold, unsigned long fade) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return;
+
+  port_def* port = _art->group[g]->ports[p];
+
+  port->lossMode = mode;
+  port->lossHold = hold;
+  port->lossFade = fade;
+
+  if (mode == LOSS_HOLD)
+    port->lossState = LOSS_STATE_IDLE;
+}
+
+// The look LOSS_FADE_SCENE fades to - DMX_BUFFER_SIZE slots that must outlive the port.  0 fades to black
+void espArtNetRDM::setLossScene(uint8_t g, uint8_t p, uint8_t* scene) {
+  if (_art == 0 || g >= _art->numGroups || _art->group[g]->ports[p] == 0)
+    return;
+  _art->group[g]->ports[p]->lossScene = scene;
 }
 
 
@@ -1368,6 +2221,33 @@ void espArtNetRDM::sendDMX(uint8_t g, uint8_t p, IPAddress bcAddress, uint8_t* d
 
 }
 
+// DMX from one of our input ports, straight into our other ports on its universe.  It merges as an Artnet
+// source from our own IP so our broadcast of it coming back over the network is the same source
+void espArtNetRDM::localDMX(uint8_t g, uint8_t p, uint8_t* data, uint16_t length) {
+  if (_art == 0 || _art->numGroups <= g || _art->group[g]->ports[p] == 0)
+    return;
+
+  uint8_t net = _art->group[g]->netSwitch;
+  uint8_t subnet = _art->group[g]->subnet;
+  uint8_t uni = _art->group[g]->ports[p]->portUni;
+  uint32_t ip = _art->deviceIP;
+  unsigned long timeNow = millis();
+
+  for (uint8_t x = 0; x < _art->numGroups; x++) {
+    group_def* group = _art->group[x];
+
+    if (net != group->netSwitch || subnet != group->subnet)
+      continue;
+
+    for (uint8_t y = 0; y < 4; y++) {
+      if (group->ports[y] == 0 || group->ports[y]->portType == DMX_IN || group->ports[y]->portUni != uni)
+        continue;
+
+      _saveDMX(data, length, x, y, ip, SOURCE_ARTNET, 0, ARTNET_DEFAULT_PRIORITY, timeNow);
+    }
+  }
+}
+
 void espArtNetRDM::setE131(uint8_t g, uint8_t p, bool a) {
   if (_art == 0 || _art->numGroups <= g || _art->group[g]->ports[p] == 0)
     return;
@@ -1378,12 +2258,16 @@ void espArtNetRDM::setE131(uint8_t g, uint8_t p, bool a) {
 
     // Clear the DMX output buffer
     artClearDMXBuffer(_art->group[g]->ports[p]->dmxBuffer);
+    _art->group[g]->ports[p]->mergeValid = false;
 
   } else if (_art->group[g]->ports[p]->e131 && !a) {
     e131Count -= 1;
 
-    // Clear the DMX output buffer
+    // Forget our sACN senders & clear the DMX output buffer
+    artDropSources(_art->group[g]->ports[p], SOURCE_E131);
+    _art->group[g]->ports[p]->e131Priority = 0;
     artClearDMXBuffer(_art->group[g]->ports[p]->dmxBuffer);
+    _art->group[g]->ports[p]->mergeValid = false;
   }
 
   _art->group[g]->ports[p]->e131 = a;
@@ -1405,6 +2289,25 @@ void espArtNetRDM::setE131Uni(uint8_t g, uint8_t p, uint16_t u) {
   _art->group[g]->ports[p]->e131Priority = 0;
 }
 
+void espArtNetRDM::setProtocolMode(uint8_t g, uint8_t p, uint8_t mode) {
+  if (_art == 0 || _art->numGroups <= g || _art->group[g]->ports[p] == 0)
+    return;
+
+  if (_art->group[g]->ports[p]->protocolMode == mode)
+    return;
+
+  // Merge again from the output buffer on the next packet
+  _art->group[g]->ports[p]->protocolMode = mode;
+  _art->group[g]->ports[p]->mergeValid = false;
+}
+
+uint8_t espArtNetRDM::getProtocolMode(uint8_t g, uint8_t p) {
+  if (_art == 0 || _art->numGroups <= g || _art->group[g]->ports[p] == 0)
+    return PROTOCOL_MERGE;
+
+  return _art->group[g]->ports[p]->protocolMode;
+}
+
 void espArtNetRDM::_e131Receive(e131_packet_t* e131Buffer) {
   if (_art == 0 || _art->numGroups == 0 || e131Count == 0)
     return;
@@ -1440,11 +2343,12 @@ void espArtNetRDM::_e131Receive(e131_packet_t* e131Buffer) {
 
   group_def* group = 0;
 
-  IPAddress rIP = fUDP.remoteIP();
+  uint32_t rIP = fUDP.remoteIP();
+  unsigned long timeNow = millis();
 
 #ifdef IP_PROTO_DEBUG
   Serial.print("espArtNetRDM::_e131Receive, IP:");
-  Serial.println(rIP);
+  Serial.println(IPAddress(rIP));
 #endif
 
   // Loop through all groups
@@ -1456,23 +2360,20 @@ void espArtNetRDM::_e131Receive(e131_packet_t* e131Buffer) {
       if (group->ports[y] == 0 || group->ports[y]->portType == DMX_IN || !group->ports[y]->e131)
         continue;
 
+      // Priority mode merges by priority so doesn't need the checks below
+      bool priorityMerge = (group->ports[y]->mergeMode == MERGE_MODE_PRIORITY);
+
       // If this port has the correct Uni, is a later packet, and is of a valid priority -> save DMX to buffer
-      if (uni == group->ports[y]->e131Uni && seq > group->ports[y]->e131Sequence && e131Buffer->priority >= group->ports[y]->e131Priority) {
+      if (uni == group->ports[y]->e131Uni && seq > group->ports[y]->e131Sequence && (priorityMerge || e131Buffer->priority >= group->ports[y]->e131Priority)) {
 
         // Drop non-zero start packets
         if (e131Buffer->property_values[0] != 0)
           continue;
 
-        // A higher priority will override previous data - this is handled in saveDMX but we need to clear the IPs & buffer
-        if (e131Buffer->priority > group->ports[y]->e131Priority) {
-          artClearDMXBuffer(group->ports[y]->dmxBuffer);
-          group->ports[y]->senderIP[0] = IPAddress(INADDR_NONE);
-          group->ports[y]->senderIP[1] = IPAddress(INADDR_NONE);
-        }
+        // A higher priority will override previous sACN data - this is handled in saveDMX
+        _saveDMX(&e131Buffer->property_values[1], numberOfChannels, x, y, rIP, SOURCE_E131, startChannel, e131Buffer->priority, timeNow);
 
         group->ports[y]->e131Priority = e131Buffer->priority;
-
-        _saveDMX(&e131Buffer->property_values[1], numberOfChannels, x, y, rIP, startChannel);
       }
 
       // If all the e131 ports are checked, then return
@@ -28,6 +28,7 @@ typedef void (*artIPCallBack)(void);
 typedef void (*artAddressCallBack)(void);
 typedef void (*artTodRequestCallBack)(uint8_t, uint8_t);
 typedef void (*artTodFlushCallBack)(uint8_t, uint8_t);
+typedef bool (*artFirmwareCallBack)(uint8_t, uint8_t*, uint16_t, uint32_t);
 
 enum port_type {
   DMX_OUT = 0,
@@ -35,6 +36,44 @@ enum port_type {
   DMX_IN = 2
 };
 
+enum merge_mode {
+  MERGE_MODE_LTP = 0,
+  MERGE_MODE_HTP = 1,
+  MERGE_MODE_PRIORITY = 2     // HTP between the highest priority sources only
+};
+
+// How Artnet & sACN share a port that has sACN enabled
+enum protocol_mode {
+  PROTOCOL_MERGE = 0,         // Sources of both protocols are merged by the merge mode
+  PROTOCOL_E131 = 1,          // Artnet sources are ignored while we have sACN sources
+  PROTOCOL_ARTNET = 2         // sACN sources are ignored while we have Artnet sources
+};
+
+// What a port outputs once all of its sources have timed out
+enum loss_mode {
+  LOSS_HOLD = 0,              // Keep the last look
+  LOSS_FADE_BLACK = 1,        // Hold for lossHold then fade to black over lossFade
+  LOSS_FADE_SCENE = 2         // Hold for lossHold then cross-fade to lossScene over lossFade
+};
+
+enum source_protocol {
+  SOURCE_ARTNET = 0,
+  SOURCE_E131 = 1,
+  SOURCE_NONE = 255
+};
+
+struct _source_def {
+  uint32_t ip;
+  uint8_t protocol;
+  uint8_t priority;
+  unsigned long lastPacketTime;
+
+  // DMX_BUFFER_SIZE slots from the port's source pool
+  uint8_t* buffer;
+};
+
+typedef struct _source_def source_def;
+
 struct _port_def {
   // DMX out/in or RDM out
   uint8_t portType;
@@ -44,6 +83,7 @@ struct _port_def {
   uint16_t e131Uni;
   uint16_t e131Sequence;
   uint8_t e131Priority;
+  uint8_t protocolMode;
 
   // Port universe
   uint8_t portUni;
@@ -52,16 +92,41 @@ struct _port_def {
   uint8_t* dmxBuffer;
   uint16_t dmxChans;
   bool ownBuffer;
-  bool mergeHTP;
+  uint8_t mergeMode;
   bool merging;
-
-  // ArtDMX input buffers for 2 IPs
-  uint8_t* ipBuffer;
-  uint16_t ipChans[2];
-
-  // IPs for current data + time of last packet
-  IPAddress senderIP[2];
-  unsigned long lastPacketTime[2];
+  bool mergeValid;   // dmxBuffer holds the merge of the source buffers
+
+  // Slots that changed in the last packet [changeStart, changeEnd)
+  uint16_t changeStart;
+  uint16_t changeEnd;
+
+  // What the DMX driver says is on the wire, for GoodOutput.  Until it's told we go by dmxChans
+  bool outputKnown;
+  bool outputActive;
+
+  // Sources we're currently merging + their buffers (allocated with the port)
+  source_def sources[ARTNET_MAX_SOURCES];
+  uint8_t numSources;
+  uint8_t maxSources;
+  unsigned long sourceTimeout;
+  uint8_t* sourceBuffer;
+  bool ownSources;
+
+  // LTP: pool buffer of the source that last changed each slot
+  uint8_t* slotOwner;
+
+  // Source loss policy.  lossScene belongs to the caller.  Fades start from a copy of the last
+  // look kept in the first source buffer, which is free once every source has gone
+  uint8_t lossMode;
+  unsigned long lossHold;
+  unsigned long lossFade;
+  uint8_t* lossScene;
+  uint8_t lossState;
+  unsigned long lossTime;
+
+  // Our space in the arena (0 if allocated separately) + how many source buffers it holds
+  uint8_t* slot;
+  uint8_t slotSources;
 
   // IPs for the last 5 RDM commands
   IPAddress rdmSenderIP[5];
@@ -85,7 +150,7 @@ struct _group_def {
   port_def* ports[4] = {0, 0, 0, 0};
   uint8_t numPorts = 0;
 
-  IPAddress cancelMergeIP;
+  uint32_t cancelMergeIP;
   bool cancelMerge;
   unsigned long cancelMergeTime;
 };
@@ -118,8 +183,26 @@ struct _artnet_def {
   uint8_t numGroups;
   uint32_t lastIPProg;
   uint32_t nextPollReply;
+  unsigned long nextMergeSweep;
+  unsigned long nextLossStep;
+
+  // One allocation holding every port's buffers, laid out by begin()
+  uint8_t* arena;
+  uint32_t arenaSize;
+  uint8_t arenaGroups;
+  uint8_t arenaSources;
+  uint8_t arenaSpares;
 
   uint16_t firmWareVersion;
+
+  // ArtFirmwareMaster upload in progress (firmwareLength is 0 when idle)
+  IPAddress firmwareIP;
+  uint8_t firmwareBlock;
+  uint32_t firmwareLength;
+  uint32_t firmwareReceived;
+  unsigned long firmwareTime;
+  bool firmwareDone;                  // The last upload finished - a resent LAST gets ALL_GOOD again
+
   uint32_t nodeReportCounter;
   uint16_t nodeReportCode;
   char nodeReport[ARTNET_NODE_REPORT_LENGTH];
@@ -132,6 +215,7 @@ struct _artnet_def {
   artAddressCallBack addressCallBack = 0;
   artTodRequestCallBack todRequestCallBack = 0;
   artTodFlushCallBack todFlushCallBack = 0;
+  artFirmwareCallBack firmwareCallBack = 0;
 };
 
 typedef struct _artnet_def artnet_device;
@@ -164,15 +248,15 @@ class espArtNetRDM {
 
     uint8_t addGroup(uint8_t, uint8_t);
 
-    uint8_t addPort(uint8_t, uint8_t, uint8_t, uint8_t, bool, uint8_t*);
-    uint8_t addPort(uint8_t group, uint8_t port, uint8_t universe, uint8_t type, bool htp) {
-      return addPort(group, port, universe, type, htp, 0);
+    uint8_t addPort(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t*);
+    uint8_t addPort(uint8_t group, uint8_t port, uint8_t universe, uint8_t type, uint8_t merge) {
+      return addPort(group, port, universe, type, merge, 0);
     };
     uint8_t addPort(uint8_t group, uint8_t port, uint8_t universe, uint8_t type) {
-      return addPort(group, port, universe, type, true, 0);
+      return addPort(group, port, universe, type, MERGE_MODE_HTP, 0);
     };
     uint8_t addPort(uint8_t group, uint8_t port, uint8_t universe) {
-      return addPort(group, port, universe, DMX_OUT, true, 0);
+      return addPort(group, port, universe, DMX_OUT, MERGE_MODE_HTP, 0);
     };
 
     bool closePort(uint8_t, uint8_t);
@@ -181,11 +265,17 @@ class espArtNetRDM {
     void pause();
     uint8_t* getDMX(uint8_t, uint8_t);
     uint16_t numChans(uint8_t, uint8_t);
+    bool getChanged(uint8_t, uint8_t, uint16_t*, uint16_t*);
+    uint32_t getBufferBytes();
+    void reserveBuffers(uint8_t);
+    uint8_t* getSpareBuffer(uint8_t);
 
     // sACN functions
     void setE131(uint8_t, uint8_t, bool);
     bool getE131(uint8_t, uint8_t);
     void setE131Uni(uint8_t, uint8_t, uint16_t);
+    void setProtocolMode(uint8_t, uint8_t, uint8_t);
+    uint8_t getProtocolMode(uint8_t, uint8_t);
 
     // handler function for including in loop()
     void handler();
@@ -198,6 +288,7 @@ class espArtNetRDM {
     void setArtAddressCallback(void (*addressCallBack)());
     void setTODRequestCallback(void (*artTodRequestCallBack)(uint8_t, uint8_t));
     void setTODFlushCallback(void (*artTodFlushCallBack)(uint8_t, uint8_t));
+    void setFirmwareCallback(bool (*artFirmwareCallBack)(uint8_t, uint8_t*, uint16_t, uint32_t));
 
     // set ArtNet uni settings
     void setNet(uint8_t, uint8_t);
@@ -220,6 +311,14 @@ class espArtNetRDM {
     // Set Merge & node name
     void setMerge(uint8_t, uint8_t, bool);
     bool getMerge(uint8_t, uint8_t);
+    void setMergeMode(uint8_t, uint8_t, uint8_t);
+    uint8_t getMergeMode(uint8_t, uint8_t);
+    void setMaxSources(uint8_t, uint8_t, uint8_t);
+    uint8_t getMaxSources(uint8_t, uint8_t);
+    void setSourceTimeout(uint8_t, uint8_t, unsigned long);
+    void setLossPolicy(uint8_t, uint8_t, uint8_t, unsigned long, unsigned long);
+    void setLossScene(uint8_t, uint8_t, uint8_t*);
+    void setOutputStatus(uint8_t, uint8_t, bool);
     void setShortName(const char*);
     const char* getShortName();
     void setLongName(const char*);
@@ -238,6 +337,7 @@ class espArtNetRDM {
     void artPollReply();
 
     void sendDMX(uint8_t, uint8_t, IPAddress, uint8_t*, uint16_t);
+    void localDMX(uint8_t, uint8_t, uint8_t*, uint16_t);
 
   private:
     artnet_device* _art = 0;
@@ -248,11 +348,16 @@ class espArtNetRDM {
     // handlers for received packets
     void _artPoll(void);
     void _artDMX(unsigned char*);
-    void _saveDMX(unsigned char*, uint16_t, uint8_t, uint8_t, IPAddress, uint16_t);
+    void _saveDMX(unsigned char*, uint16_t, uint8_t, uint8_t, uint32_t, uint8_t, uint16_t, uint8_t, unsigned long);
+    void _mergeSweep();
+    void _lossStep();
+    void _arenaStart();
     void _artIPProg(unsigned char*);
     void _artAddress(unsigned char*);
     void _artSync(unsigned char*);
-    void _artFirmwareMaster(unsigned char*);
+    void _artFirmwareMaster(unsigned char*, uint16_t);
+    void _artFirmwareReply(IPAddress, uint8_t);
+    void _artFirmwareAbort();
     void _artTODRequest(unsigned char*);
     void _artTODControl(unsigned char*);
     void _artRDM(unsigned char*, uint16_t);
@@ -25,28 +25,46 @@
 #define UART_TXD_IDX(u)     ((u==0)?U0TXD_OUT_IDX:(         (u==1)?U1TXD_OUT_IDX:(        (u==2)?U2TXD_OUT_IDX:0)))
 #define UART_INTR_SOURCE(u) ((u==0)?ETS_UART0_INTR_SOURCE:( (u==1)?ETS_UART1_INTR_SOURCE:((u==2)?ETS_UART2_INTR_SOURCE:0)))
 
-static intr_handle_t uart_intr_handle[2] = { 0 };
-static uart_dev_t *uart_dev_array[2] = {
+static intr_handle_t uart_intr_handle[3] = { 0 };
+static uart_dev_t *uart_dev_array[3] = {
   (volatile uart_dev_t *)(DR_REG_UART_BASE),
   (volatile uart_dev_t *)(DR_REG_UART1_BASE),
+  (volatile uart_dev_t *)(DR_REG_UART2_BASE),
+};
+
+// Default pins for each UART.  Ports 0 & 1 share the RX pin so only one can receive at a time
+static const uint8_t dmx_tx_pins[3] = { 1, 2, 17 };
+static const uint8_t dmx_rx_pins[3] = { 3, 3, 16 };
+
+// break, MAB, slot gap, min slots, extra slots, max refresh, keepalive, full universe time
+static const dmx_timing dmx_timing_profiles[DMX_TIMING_PROFILES] = {
+  { DMX_TX_BREAK_BITS, DMX_TX_MAB_BITS, 0, DMX_MIN_CHANS, DMX_ADD_CHANS, 0, DMX_KEEPALIVE, DMX_FULL_UNI_TIMING },
+  { 23, 3, 0, 24, 0, 830, 0, DMX_FULL_UNI_TIMING },              // 92us break, 12us MAB, 1204us break to break
+  { 44, 5, 1, 512, 0, 40, DMX_KEEPALIVE, DMX_FULL_UNI_TIMING },  // 176us break, 20us MAB
 };
 
 espDMX dmxA(0);
 espDMX dmxB(1);
+espDMX dmxC(2);
 
-void dmx_interrupt_handler(void);
+void dmx_interrupt_handler(void* arg);
 
 uint16_t dmx_get_tx_fifo_room(dmx_t* dmx);
-void dmx_interrupt_enable(dmx_t* dmx);
+void dmx_interrupt_enable(dmx_t* dmx, espDMX* owner);
 void dmx_interrupt_arm(dmx_t* dmx);
 void dmx_interrupt_disarm(dmx_t* dmx);
+void dmx_break_start(dmx_t* dmx);
 void rdm_interrupt_arm(dmx_t* dmx);
-void rdm_interrupt_disarm();
+void rdm_interrupt_disarm(dmx_t* dmx);
 void dmx_set_baudrate(dmx_t* dmx, int baud_rate);
 void dmx_set_chans(dmx_t* dmx, uint8_t* data, uint16_t numChans, uint16_t startChan);
 void dmx_buffer_update(dmx_t* dmx, uint16_t num);
 int dmx_state(dmx_t* dmx);
-void rx_flush();
+void dmx_rx_attach(dmx_t* dmx);
+void dmx_rmt_init(dmx_t* dmx);
+uint16_t dmx_rmt_encode(dmx_t* dmx, uint16_t num);
+void dmx_set_timing(dmx_t* dmx, const dmx_timing* timing);
+void rx_flush(dmx_t* dmx);
 void dmx_flush(dmx_t* dmx);
 static void uart_ignore_char(char c);
 
@@ -54,146 +72,375 @@ void dmx_set_buffer(dmx_t* dmx, uint8_t* buf);
 
 void dmx_uninit(dmx_t* dmx);
 
-static bool timer1Set = false;
-static bool rdmInUse = false;
-static bool rdmBreak = false;
 static bool rdm_pause = false;
-static bool dmx_input = false;
-static uint8_t rxUser;
-static unsigned long rdmTimer = 0;
 
-void ICACHE_RAM_ATTR dmx_interrupt_handler(void) {
+// Do we want a frame by the time the UART is idle (ahead us from now).  Frames go out for new data or
+// when the keepalive is up, but never inside the refresh limit
+static inline bool ICACHE_RAM_ATTR dmx_frame_wanted(dmx_t* dmx, uint32_t ahead) {
+  uint32_t since = micros() + ahead - dmx->frame_time;
+
+  if (dmx->frame_us != 0 && since < dmx->frame_us)
+    return false;
+
+  return dmx->newDMX || dmx->keepalive_us == 0 || since >= dmx->keepalive_us;
+}
+
+// frame_state holds which of frames[] we're writing, which is the latest complete one & which is
+// being sent, plus a flag for the ready one being newer than the one being sent
+#define DMX_FRAME_WRITE(s)        ((s) & 3)
+#define DMX_FRAME_READY(s)        (((s) >> 2) & 3)
+#define DMX_FRAME_TX(s)           (((s) >> 4) & 3)
+#define DMX_FRAME_FRESH           0x40
+#define DMX_FRAME_STATE(w, r, t)  ((w) | ((r) << 2) | ((t) << 4))
+
+static inline bool ICACHE_RAM_ATTR dmx_frame_cas(volatile uint32_t* state, uint32_t compare, uint32_t* set) {
+  uxPortCompareSet(state, compare, set);
+  return *set == compare;
+}
+
+// Lookup table for each curve, built the first time a port uses it.  Linear has none
+static uint8_t* dmx_curve_lut[DMX_CURVES] = { 0 };
+
+static uint8_t dmx_curve_value(uint8_t curve, uint32_t x) {
+  switch (curve) {
+    case DMX_CURVE_SQUARE:
+      return (x * x + 127) / 255;
+
+    case DMX_CURVE_SCURVE:
+      // 3x^2 - 2x^3, scaled to 0-255
+      return (x * x * (765 - 2 * x) + 32512) / 65025;
+
+    case DMX_CURVE_ROOT: {
+      // Rounded square root of x * 255
+      uint32_t v = x * 255;
+      uint32_t r = 0;
+      while ((r + 1) * (r + 1) <= v)
+        r++;
+      return (v - r * r > r) ? r + 1 : r;
+    }
+
+    case DMX_CURVE_INVERT:
+      return 255 - x;
+
+    default:
+      return x;
+  }
+}
+
+static const uint8_t* dmx_curve_table(uint8_t curve) {
+  if (curve == DMX_CURVE_LINEAR || curve >= DMX_CURVES)
+    return 0;
+
+  if (dmx_curve_lut[curve] == 0) {
+    uint8_t* lut = (uint8_t*) malloc(256);
+    if (lut == 0)
+      return 0;
 
-  // stop other interrupts for TX
-  noInterrupts();
+    for (uint16_t x = 0; x < 256; x++)
+      lut[x] = dmx_curve_value(curve, x);
 
-  if (uart_dev_array[0]->int_st.txfifo_empty) {
-    uart_dev_array[0]->int_clr.txfifo_empty = 1; // clear status flag
-    dmxA._transmit();
+    dmx_curve_lut[curve] = lut;
   }
 
-  if (uart_dev_array[1]->int_st.txfifo_empty) {
-    uart_dev_array[1]->int_clr.txfifo_empty = 1; // clear status flag
-    dmxA._transmit();
+  return dmx_curve_lut[curve];
+}
+
+// Copy a frame, putting the slots with a curve through its table on the way
+static void dmx_curve_copy(uint8_t* dst, const uint8_t* src, const dmx_curves* curves) {
+  uint16_t pos = 0;
+
+  if (curves != 0) {
+    for (uint8_t x = 0; x < curves->num; x++) {
+      const dmx_curve_range* r = &curves->range[x];
+      const uint8_t* lut = dmx_curve_lut[r->curve];
+
+      memcpy(&dst[pos], &src[pos], r->start - pos);
+
+      for (uint16_t y = r->start; y < r->end; y++)
+        dst[y] = lut[src[y]];
+
+      pos = r->end;
+    }
   }
 
-  interrupts();
+  memcpy(&dst[pos], &src[pos], 512 - pos);
+}
 
-  // RDM replies
-  if (rdmInUse) {
-    if ((uart_dev_array[0]->int_st.brk_det) || ( uart_dev_array[0]->int_st.frm_err)) {    // RX0 Break Detect
-      uart_dev_array[0]->int_clr.brk_det = 1; // clear status flag
-      uart_dev_array[0]->int_clr.frm_err = 1; // clear status flag
-      rdmBreak = true;
+// Network side: copy data into the frame we own, then swap it with the ready one.  Only the network
+// side writes data so it's complete here
+static void dmx_frame_publish(dmx_t* dmx) {
+  uint32_t state = dmx->frame_state;
+
+  dmx_curve_copy(dmx->frames[DMX_FRAME_WRITE(state)], dmx->data, dmx->curves);
+
+  for (;;) {
+    uint32_t next = DMX_FRAME_STATE(DMX_FRAME_READY(state), DMX_FRAME_WRITE(state), DMX_FRAME_TX(state)) | DMX_FRAME_FRESH;
+    uint32_t seen = next;
+
+    if (dmx_frame_cas(&dmx->frame_state, state, &seen))
+      return;
+    state = seen;
+  }
+}
+
+// TX side: take the latest complete frame if there's a newer one.  No copy - just a pointer
+static void ICACHE_RAM_ATTR dmx_frame_take(dmx_t* dmx) {
+  uint32_t state = dmx->frame_state;
+
+  while (state & DMX_FRAME_FRESH) {
+    uint32_t next = DMX_FRAME_STATE(DMX_FRAME_WRITE(state), DMX_FRAME_TX(state), DMX_FRAME_READY(state));
+    uint32_t seen = next;
+
+    if (dmx_frame_cas(&dmx->frame_state, state, &seen)) {
+      state = next;
+      break;
     }
+    state = seen;
+  }
 
-    if (uart_dev_array[0]->int_st.rxfifo_full) {   // RX0 Fifo Full
-      if (rxUser == 0)
-        dmxA.rdmReceived();
-      else
-        dmxB.rdmReceived();
+  dmx->data1 = dmx->frames[DMX_FRAME_TX(state)];
+}
+
+// Publish new data & note it for the scheduler & when it arrived for the latency stats
+static void dmx_new_data(dmx_t* dmx) {
+  dmx_frame_publish(dmx);
+
+  portENTER_CRITICAL(&dmx->mux);
+  if (!dmx->newDMX)
+    dmx->data_time = micros();
+  dmx->newDMX = true;
+  portEXIT_CRITICAL(&dmx->mux);
+}
+
+static inline uint32_t ICACHE_RAM_ATTR dmx_ccount(void) {
+#ifdef ESPDMX_HOST
+  return host_ccount();
+#else
+  uint32_t ccount;
+  __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+  return ccount;
+#endif
+}
+
+// Break to break time & its jitter.  Cycle counts are per core so these all come from the core our
+// interrupt runs on - begin(), handler() & setChans() have to be called from there too
+static void ICACHE_RAM_ATTR dmx_break_stats(dmx_t* dmx, uint32_t breakStart) {
+  if (dmx->last_break_ccount != 0) {
+    uint32_t period = (breakStart - dmx->last_break_ccount) / dmx->cpu_mhz;
+
+    if (dmx->stats.periodUs == 0)
+      dmx->stats.periodUs = period;
+    else
+      dmx->stats.periodUs = (dmx->stats.periodUs * 7 + period) / 8;
+
+    if (dmx->last_period != 0) {
+      uint32_t jitter = (period > dmx->last_period) ? period - dmx->last_period : dmx->last_period - period;
+      uint8_t b = 0;
+
+      for (uint32_t lim = 8; b < DMX_JITTER_BUCKETS - 1 && jitter >= lim; lim <<= 2)
+        b++;
+      dmx->stats.jitter[b]++;
     }
+    dmx->last_period = period;
+  }
 
-    // DMX input
-  } else if (dmx_input) {
+  dmx->last_break_ccount = breakStart;
+}
+
+// Called as the start code goes out
+static void ICACHE_RAM_ATTR dmx_frame_stats(dmx_t* dmx, uint32_t now) {
+  dmx->stats.frames++;
+  dmx->stats.lastFrame = millis();
+
+  if (!dmx->frame_new) {
+    dmx->stats.keepAlives++;
+    return;
+  }
+
+  uint32_t latency = now - dmx->frame_data_time;
+
+  dmx->stats.latency = latency;
+  if (latency > dmx->stats.latencyMax)
+    dmx->stats.latencyMax = latency;
+  if (dmx->stats.latencyAvg == 0)
+    dmx->stats.latencyAvg = latency;
+  else
+    dmx->stats.latencyAvg = (dmx->stats.latencyAvg * 7 + latency) / 8;
+}
+
+// Each UART has its own interrupt with its port as the argument so the ports never wait on each other
+void ICACHE_RAM_ATTR dmx_interrupt_handler(void* arg) {
+  espDMX* port = (espDMX*) arg;
+  dmx_t* dmx = port->_dmx;
+  uart_dev_t* uart = uart_dev_array[port->_dmx_nr];
+
+  if (dmx == 0) {
+    uart->int_ena.val = 0;
+    uart->int_clr.val = 0xffffffff;
+    return;
+  }
+
+  portENTER_CRITICAL_ISR(&dmx->mux);
+
+  if (uart->int_st.txfifo_empty) {
+    uart->int_clr.txfifo_empty = 1; // clear status flag
+    port->_transmit();
+  }
+
+  // Last slot has gone so the break starts now
+  if (uart->int_st.tx_done) {
+    uart->int_clr.tx_done = 1;
+    uart->int_ena.tx_done = 0;
+    dmx->break_ccount = dmx_ccount();
+  }
 
-    // Data received
-    while (uart_dev_array[0]->int_st.rxfifo_full) {
-      if (rxUser == 0)
-        dmxA.dmxReceived((uint8_t)uart_dev_array[0]->fifo.rw_byte);
-      else
-        dmxB.dmxReceived((uint8_t)uart_dev_array[0]->fifo.rw_byte);
+  // Hardware break is done - start the frame
+  if (uart->int_st.tx_brk_done) {
+    uart->int_clr.tx_brk_done = 1;
+    port->_breakDone();
+  }
 
-      uart_dev_array[0]->int_clr.rxfifo_full = 1;
+  // MAB is done - data follows
+  if (uart->int_st.tx_brk_idle_done) {
+    uart->int_clr.tx_brk_idle_done = 1;
+    uart->int_ena.tx_brk_idle_done = 0;
+    dmx->stats.mabUs = (dmx_ccount() - dmx->brk_done_ccount) / dmx->cpu_mhz;
+  }
+
+  // RDM replies
+  if (dmx->rdm_in_use) {
+    if ((uart->int_st.brk_det) || (uart->int_st.frm_err)) {    // RX Break Detect
+      uart->int_clr.brk_det = 1; // clear status flag
+      uart->int_clr.frm_err = 1; // clear status flag
+      dmx->rdm_break = true;
     }
 
-    // Break/Frame error detect
-    if ((uart_dev_array[0]->int_st.brk_det) || (uart_dev_array[0]->int_st.frm_err)) {    // RX0 Break Detect
-      uart_dev_array[0]->int_clr.brk_det = 1;
-      uart_dev_array[0]->int_clr.frm_err = 1;
+    if (uart->int_st.rxfifo_full)    // RX Fifo Full
+      port->rdmReceived();
+
+    // DMX input
+  } else if (dmx->isInput) {
+
+    // Break/Frame error detect - the FIFO holds the end of the last frame then the break's null
+    if ((uart->int_st.brk_det) || (uart->int_st.frm_err)) {    // RX Break Detect
+      if (!uart->int_st.brk_det)
+        dmx->stats.frameErrors++;
+
+      uart->int_clr.brk_det = 1;
+      uart->int_clr.frm_err = 1;
 
-      if (rxUser == 0)
-        dmxA.inputBreak();
-      else
-        dmxB.inputBreak();
+      port->dmxReceived(true, false);
+      port->inputBreak();
+
+      // Data received - FIFO over threshold or the line's gone quiet
+    } else if (uart->int_st.rxfifo_full || uart->int_st.rxfifo_tout) {
+      port->dmxReceived(false, uart->int_st.rxfifo_tout);
     }
+
+    uart->int_clr.rxfifo_full = 1;
+    uart->int_clr.rxfifo_tout = 1;
   }
+
+  portEXIT_CRITICAL_ISR(&dmx->mux);
 }
 
 static void uart_ignore_char(char c) {
   return;
 }
 
-uint16_t dmx_get_tx_fifo_room(dmx_t* dmx) {
+uint16_t ICACHE_RAM_ATTR dmx_get_tx_fifo_room(dmx_t* dmx) {
   if (dmx == 0 || dmx->state == DMX_NOT_INIT)
     return 0;
-  return UART_TX_FIFO_SIZE - uart_dev_array[0]->status.txfifo_cnt;
+  return UART_TX_FIFO_SIZE - uart_dev_array[dmx->dmx_nr]->status.txfifo_cnt;
 }
 
 void dmx_flush(dmx_t* dmx) {
   if (dmx == 0 || dmx->state == DMX_NOT_INIT)
     return;
+
+  if (dmx->rmtChannel != DMX_RMT_NONE) {
+    rmt_wait_tx_done((rmt_channel_t)dmx->rmtChannel, portMAX_DELAY);
+    return;
+  }
+
   // copied from esp32-hal-uart.c
-  while (uart_dev_array[0]->status.txfifo_cnt || uart_dev_array[0]->status.st_utx_out) {};
+  while (uart_dev_array[dmx->dmx_nr]->status.txfifo_cnt || uart_dev_array[dmx->dmx_nr]->status.st_utx_out) {};
 }
 
-void rx_flush() {
+void ICACHE_RAM_ATTR rx_flush(dmx_t* dmx) {
+  uart_dev_t* uart = uart_dev_array[dmx->dmx_nr];
+
   // copied from esp32-hal-uart.c
-  while (uart_dev_array[0]->status.rxfifo_cnt != 0 || (uart_dev_array[0]->mem_rx_status.wr_addr != uart_dev_array[0]->mem_rx_status.rd_addr)) {
-    READ_PERI_REG(UART_FIFO_REG(0));
+  while (uart->status.rxfifo_cnt != 0 || (uart->mem_rx_status.wr_addr != uart->mem_rx_status.rd_addr)) {
+    (void)(uint8_t)uart->fifo.rw_byte;
   }
 }
 
-void dmx_interrupt_enable(dmx_t* dmx) {
-  if (dmx == 0 || dmx->state == DMX_NOT_INIT)
+// Connect our RX pin to our UART
+void dmx_rx_attach(dmx_t* dmx) {
+  pinMode(dmx->rxPin, INPUT);
+  pinMatrixInAttach(dmx->rxPin, UART_RXD_IDX(dmx->dmx_nr), false);
+}
+
+void dmx_interrupt_enable(dmx_t* dmx, espDMX* owner) {
+  if (dmx == 0 || dmx->state == DMX_NOT_INIT || dmx->rmtChannel != DMX_RMT_NONE)
     return;
 
+  uart_dev_t* uart = uart_dev_array[dmx->dmx_nr];
+
   // Clear all interrupt bits
-  uart_dev_array[dmx->dmx_nr]->int_clr.val = 0xffffffff;
+  uart->int_ena.val = 0;
+  uart->int_clr.val = 0xffffffff;
 
-  // UART1 setup
-  if (dmx->dmx_nr == 1) {
-    // Set TX Fifo Empty trigger point
-    uart_dev_array[1]->conf1.txfifo_empty_thrhd = 0;
+  // Set TX Fifo Empty trigger point
+  uart->conf1.txfifo_empty_thrhd = 0;
+  uart->conf1.rxfifo_full_thrhd = 127;
 
-    uint32_t clk_div = ((getApbFrequency() << 4) / DMX_TX_BAUD);
-    uart_dev_array[1]->clk_div.div_int = clk_div >> 4 ;
-    uart_dev_array[1]->clk_div.div_frag = clk_div & 0xf;
+  uint32_t clk_div = ((getApbFrequency() << 4) / DMX_TX_BAUD);
+  uart->clk_div.div_int = clk_div >> 4 ;
+  uart->clk_div.div_frag = clk_div & 0xf;
 
-    // set to 8N2
-    uart_dev_array[1]->conf0.parity = 0;
-    uart_dev_array[1]->conf0.parity_en = 0;
-    uart_dev_array[1]->conf0.bit_num = 3;
-    uart_dev_array[1]->conf0.stop_bit_num = 3;
+  // set to 8N2
+  uart->conf0.parity = 0;
+  uart->conf0.parity_en = 0;
+  uart->conf0.bit_num = 3;
+  uart->conf0.stop_bit_num = 3;
 
-    uart_dev_array[1]->int_clr.val = 0xffffffff;
+  uart->int_clr.val = 0xffffffff;
 
-    esp_intr_alloc(UART_INTR_SOURCE(1), (int)ESP_INTR_FLAG_IRAM, (void (*)(void *))&dmx_interrupt_handler, NULL, &uart_intr_handle[1]);
-  }
+  // Break, MAB & slot gap
+  dmx_set_timing(dmx, &dmx->timing);
 
-  // UART0 setup
-  if (!timer1Set) {
-    timer1Set = true;
+  // Our own interrupt, only allocated once
+  if (uart_intr_handle[dmx->dmx_nr] == 0)
+    esp_intr_alloc(UART_INTR_SOURCE(dmx->dmx_nr), (int)ESP_INTR_FLAG_IRAM, &dmx_interrupt_handler, owner, &uart_intr_handle[dmx->dmx_nr]);
+}
 
-    uint32_t clk_div = ((getApbFrequency() << 4) / DMX_TX_BAUD);
-    uart_dev_array[0]->clk_div.div_int = clk_div >> 4 ;
-    uart_dev_array[0]->clk_div.div_frag = clk_div & 0xf;
+// Takes effect from the next frame.  RMT ports pick it up as they encode
+void dmx_set_timing(dmx_t* dmx, const dmx_timing* timing) {
+  if (dmx == 0)
+    return;
 
-    // set to 8N2
-    uart_dev_array[0]->conf0.parity = 0;
-    uart_dev_array[0]->conf0.parity_en = 0;
-    uart_dev_array[0]->conf0.bit_num = 3;
-    uart_dev_array[0]->conf0.stop_bit_num = 3;
+  portENTER_CRITICAL(&dmx->mux);
 
-    uart_dev_array[0]->conf1.rxfifo_full_thrhd = 127;
+  dmx->timing = *timing;
+  dmx->frame_us = (timing->maxRefresh == 0) ? 0 : (1000000UL / timing->maxRefresh);
+  dmx->keepalive_us = timing->keepAlive * 1000UL;
 
-    uart_dev_array[0]->int_clr.val = 0xffffffff;
+  if (dmx->state != DMX_NOT_INIT && dmx->rmtChannel == DMX_RMT_NONE) {
+    uart_dev_t* uart = uart_dev_array[dmx->dmx_nr];
 
-    esp_intr_alloc(UART_INTR_SOURCE(0), (int)ESP_INTR_FLAG_IRAM, (void (*)(void *))&dmx_interrupt_handler, NULL, &uart_intr_handle[0]);
+    uart->idle_conf.tx_brk_num = timing->breakBits;
+    uart->idle_conf.tx_idle_num = timing->mabBits;
+
+    // Delays the stop bits by one bit
+    uart->rs485_conf.dl1_en = (timing->slotGap > 0);
   }
+
+  portEXIT_CRITICAL(&dmx->mux);
 }
 
-void dmx_interrupt_arm(dmx_t* dmx) {
+void ICACHE_RAM_ATTR dmx_interrupt_arm(dmx_t* dmx) {
   if (dmx == 0 || dmx->state == DMX_NOT_INIT)
     return;
   // Clear all interupt bits
@@ -204,43 +451,126 @@ void dmx_interrupt_arm(dmx_t* dmx) {
 }
 
 void dmx_interrupt_disarm(dmx_t* dmx) {
-  if (dmx == 0 || dmx->state == DMX_NOT_INIT)
+  if (dmx == 0 || dmx->state == DMX_NOT_INIT || dmx->rmtChannel != DMX_RMT_NONE)
     return;
+
+  // Frames chain from our interrupt so keep it out while we take both apart
+  portENTER_CRITICAL(&dmx->mux);
   uart_dev_array[dmx->dmx_nr]->int_ena.txfifo_empty = 0;
+
+  // Cancel any break that hasn't finished
+  uart_dev_array[dmx->dmx_nr]->int_ena.tx_brk_done = 0;
+  uart_dev_array[dmx->dmx_nr]->int_ena.tx_brk_idle_done = 0;
+  uart_dev_array[dmx->dmx_nr]->int_ena.tx_done = 0;
+  uart_dev_array[dmx->dmx_nr]->conf0.txd_brk = 0;
+  portEXIT_CRITICAL(&dmx->mux);
+}
+
+// Send a break once the UART has finished sending.  The MAB follows it & the interrupt starts the frame
+void ICACHE_RAM_ATTR dmx_break_start(dmx_t* dmx) {
+  if (dmx == 0 || dmx->state == DMX_NOT_INIT)
+    return;
+
+  // Time the break from when the UART is idle
+  if (uart_dev_array[dmx->dmx_nr]->status.txfifo_cnt == 0 && uart_dev_array[dmx->dmx_nr]->status.st_utx_out == 0) {
+    dmx->break_ccount = dmx_ccount();
+  } else {
+    dmx->break_ccount = 0;
+    uart_dev_array[dmx->dmx_nr]->int_clr.tx_done = 1;
+    uart_dev_array[dmx->dmx_nr]->int_ena.tx_done = 1;
+  }
+
+  uart_dev_array[dmx->dmx_nr]->int_clr.tx_brk_done = 1;
+  uart_dev_array[dmx->dmx_nr]->int_ena.tx_brk_done = 1;
+  uart_dev_array[dmx->dmx_nr]->conf0.txd_brk = 1;
 }
 
-void rdm_interrupt_arm(dmx_t* dmx) {
+void ICACHE_RAM_ATTR rdm_interrupt_arm(dmx_t* dmx) {
   if (dmx == 0 || dmx->state == DMX_NOT_INIT)
     return;
 
   // Enable RX Fifo Full & Break Detect & Frame Error Interupts
-  uart_dev_array[0]->int_ena.rxfifo_full = 1;
-  uart_dev_array[0]->int_ena.brk_det = 1;
-  uart_dev_array[0]->int_ena.frm_err = 1;
+  uart_dev_array[dmx->dmx_nr]->int_ena.rxfifo_full = 1;
+  uart_dev_array[dmx->dmx_nr]->int_ena.brk_det = 1;
+  uart_dev_array[dmx->dmx_nr]->int_ena.frm_err = 1;
 
   digitalWrite(dmx->dirPin, LOW);
-  rdmBreak = false;
-  rxUser = dmx->dmx_nr;
+  dmx->rdm_break = false;
   dmx->rx_pos = 0;
   dmx->rdm_response.clear();
 
-  // Timer1 start
-  // T1L = ((RDM_LISTEN_TIME)& 0x7FFFFF);
-  // TEIE |= TEIE1;//edge int enable
-
-  rdmTimer = micros() + 3000;
+  dmx->rdm_timer = micros() + 3000;
 }
 
-void rdm_interrupt_disarm() {
+void rdm_interrupt_disarm(dmx_t* dmx) {
   // Disable RX Fifo Full & Break Detect & Frame Error Interupts
-  uart_dev_array[0]->int_ena.rxfifo_full = 0;
-  uart_dev_array[0]->int_ena.brk_det = 0;
-  uart_dev_array[0]->int_ena.frm_err = 0;
+  uart_dev_array[dmx->dmx_nr]->int_ena.rxfifo_full = 0;
+  uart_dev_array[dmx->dmx_nr]->int_ena.brk_det = 0;
+  uart_dev_array[dmx->dmx_nr]->int_ena.frm_err = 0;
 
-  // TEIE &= ~TEIE1;//edge int disable
-  // T1L = 0;
+  dmx->rdm_in_use = false;
+}
 
-  rdmInUse = false;
+// RMT output with 1us ticks.  The line idles high (mark) between frames
+void dmx_rmt_init(dmx_t* dmx) {
+  rmt_config_t config;
+  memset(&config, 0, sizeof(config));
+
+  config.rmt_mode = RMT_MODE_TX;
+  config.channel = (rmt_channel_t)dmx->rmtChannel;
+  config.gpio_num = (gpio_num_t)dmx->txPin;
+  config.clk_div = DMX_RMT_CLK_DIV;
+  config.mem_block_num = 1;
+  config.tx_config.loop_en = false;
+  config.tx_config.carrier_en = false;
+  config.tx_config.idle_output_en = true;
+  config.tx_config.idle_level = RMT_IDLE_LEVEL_HIGH;
+
+  rmt_config(&config);
+  rmt_driver_install(config.channel, 0, 0);
+
+  dmx->rmtItems = (rmt_item32_t*) malloc(sizeof(rmt_item32_t) * DMX_RMT_ITEMS);
+}
+
+// Encode a break, MAB, start code & num slots from data1.  Each slot is a low run followed by a
+// high run until the stop bits, so it always fills whole items
+uint16_t dmx_rmt_encode(dmx_t* dmx, uint16_t num) {
+  rmt_item32_t* items = dmx->rmtItems;
+  uint8_t* data = dmx->data1;
+  uint16_t gap = dmx->timing.slotGap * DMX_RMT_BIT_TICKS;
+  uint16_t n = 0;
+
+  items[n].level0 = 0;
+  items[n].duration0 = dmx->timing.breakBits * DMX_RMT_BIT_TICKS;
+  items[n].level1 = 1;
+  items[n].duration1 = dmx->timing.mabBits * DMX_RMT_BIT_TICKS;
+  n++;
+
+  for (int16_t s = -1; s < num; s++) {
+    // Start bit, 8 data bits LSB first & 2 stop bits.  Start code is 0
+    uint16_t bits = (s < 0) ? 0x600 : (((uint16_t)data[s] << 1) | 0x600);
+    uint8_t x = 0;
+
+    while (x < 11) {
+      uint8_t start = x;
+      while (x < 11 && !((bits >> x) & 1))
+        x++;
+      items[n].level0 = 0;
+      items[n].duration0 = (x - start) * DMX_RMT_BIT_TICKS;
+
+      start = x;
+      while (x < 11 && ((bits >> x) & 1))
+        x++;
+      items[n].level1 = 1;
+      items[n].duration1 = (x - start) * DMX_RMT_BIT_TICKS;
+      n++;
+    }
+
+    // Slot gap lengthens the stop bits
+    items[n - 1].duration1 += gap;
+  }
+
+  return n;
 }
 
 void dmx_set_baudrate(dmx_t* dmx, int baud_rate) {
@@ -256,7 +586,7 @@ void dmx_clear_buffer(dmx_t* dmx) {
   for (int i = 0; i < 512; i++)
     dmx->data[i] = 0;
 
-  dmx->numChans = DMX_MIN_CHANS;
+  dmx->numChans = dmx->timing.minChans;
 }
 
 void dmx_set_buffer(dmx_t* dmx, uint8_t* buf) {
@@ -289,6 +619,12 @@ void dmx_uninit(dmx_t* dmx) {
   dmx_interrupt_disarm(dmx);
   dmx_flush(dmx);
 
+  if (dmx->rmtChannel != DMX_RMT_NONE) {
+    rmt_driver_uninstall((rmt_channel_t)dmx->rmtChannel);
+    free(dmx->rmtItems);
+    dmx->rmtItems = NULL;
+  }
+
   pinMode(dmx->txPin, OUTPUT);
   digitalWrite(dmx->txPin, HIGH);
 
@@ -296,9 +632,17 @@ void dmx_uninit(dmx_t* dmx) {
   if (dmx->dirPin != 255)
     digitalWrite(dmx->dirPin, LOW);
 
-  if (dmx->dmx_nr == rxUser) {
-    rdm_interrupt_disarm();
-    rx_flush();
+  if (dmx->rdm_in_use || dmx->isInput) {
+    rdm_interrupt_disarm(dmx);
+    rx_flush(dmx);
+  }
+
+  // Release our interrupt
+  if (dmx->rmtChannel == DMX_RMT_NONE)
+    uart_dev_array[dmx->dmx_nr]->int_ena.val = 0;
+  if (dmx->dmx_nr < 3 && uart_intr_handle[dmx->dmx_nr] != 0) {
+    esp_intr_free(uart_intr_handle[dmx->dmx_nr]);
+    uart_intr_handle[dmx->dmx_nr] = 0;
   }
 
   if (dmx->rdm_enable) {
@@ -312,9 +656,15 @@ void dmx_uninit(dmx_t* dmx) {
     dmx->todCallBack = NULL;
   }
 
-  free(dmx->data1);
+  if (dmx->ownBuffer1)
+    free(dmx->frames[0]);
+  free(dmx->frames[1]);
+  free(dmx->frames[2]);
+  dmx->frames[0] = dmx->frames[1] = dmx->frames[2] = 0;
   dmx->data1 = 0;
 
+  if (dmx->isInput)
+    dmx->data = dmx->outData;
   dmx->isInput = false;
   dmx->inputCallBack = NULL;
 
@@ -347,24 +697,24 @@ void dmx_set_chans(dmx_t* dmx, uint8_t* data, uint16_t num, uint16_t start) {
       if (dmx->data[newNum - 1] != data[num - 1])
         break;
     }
-    newNum += DMX_ADD_CHANS;
+    newNum += dmx->timing.addChans;
 
     // If we receive tiny data input, just output minimum channels
-    if (newNum < DMX_MIN_CHANS)
-      newNum = DMX_MIN_CHANS;
+    if (newNum < dmx->timing.minChans)
+      newNum = dmx->timing.minChans;
 
     // Put data into our buffer
     memcpy(&(dmx->data[start - 1]), data, num);
 
     if (newNum > dmx->numChans)
       dmx->numChans = (newNum > 512) ? 512 : newNum;
-    dmx->newDMX = true;
-    //dmx_transmit(dmx);
+    dmx_new_data(dmx);
   }
 }
 
+// Our buffer has been written directly - num is the channel count it was given
 void dmx_buffer_update(dmx_t* dmx, uint16_t num) {
-  if (dmx == 0 || dmx->state == DMX_NOT_INIT || num <= dmx->numChans)
+  if (dmx == 0 || dmx->state == DMX_NOT_INIT)
     return;
 
   dmx->started = true;
@@ -372,35 +722,40 @@ void dmx_buffer_update(dmx_t* dmx, uint16_t num) {
   if (num > 512)
     num = 512;
 
-  // Find the highest channel with data
-  for (; num >= dmx->numChans; num--) {
-    if (dmx->data[num - 1] != 0)
-      break;
-  }
-  num += DMX_ADD_CHANS;
+  if (num > dmx->numChans) {
+    // Find the highest channel with data
+    for (; num >= dmx->numChans; num--) {
+      if (dmx->data[num - 1] != 0)
+        break;
+    }
+    num += dmx->timing.addChans;
 
-  // If we receive tiny data input, just output minimum channels
-  if (num < DMX_MIN_CHANS)
-    num = DMX_MIN_CHANS;
+    // If we receive tiny data input, just output minimum channels
+    if (num < dmx->timing.minChans)
+      num = dmx->timing.minChans;
 
-  if (num > dmx->numChans)
-    dmx->numChans = (num > 512) ? 512 : num;
+    if (num > dmx->numChans)
+      dmx->numChans = (num > 512) ? 512 : num;
+  }
 
-  dmx->newDMX = true;
-  //dmx_transmit(dmx);
+  dmx_new_data(dmx);
 }
 
+// Numbers past the UARTs are for RMT outputs - see setRMT()
 espDMX::espDMX(uint8_t dmx_nr) :
-  _dmx_nr(dmx_nr), _dmx(0) {
+  _dmx_nr(dmx_nr), _txPin(dmx_nr < 3 ? dmx_tx_pins[dmx_nr] : 255), _rxPin(dmx_nr < 3 ? dmx_rx_pins[dmx_nr] : 255),
+  _rmtChannel(DMX_RMT_NONE), _timing(dmx_timing_profiles[DMX_TIMING_STANDARD]), _dmx(0) {
+  _curves.num = 0;
 }
 
 espDMX::~espDMX(void) {
   end();
 }
 
-void espDMX::begin(uint8_t dir, uint8_t* buf) {
+void espDMX::begin(uint8_t dir, uint8_t* buf, uint8_t* buf1) {
   if (_dmx == 0) {
-    _dmx = (dmx_t*) malloc(sizeof(dmx_t));
+    // Our interrupt uses this so keep it in internal RAM
+    _dmx = (dmx_t*) heap_caps_malloc(sizeof(dmx_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
 
     if (_dmx == 0) {
       free(_dmx);
@@ -408,8 +763,21 @@ void espDMX::begin(uint8_t dir, uint8_t* buf) {
       return;
     }
 
-    _dmx->data1 = (uint8_t*) malloc(sizeof(uint8_t) * 512);
-    memset(_dmx->data1, 0, 512);
+    // Transmit/receive frames - use the one we're given if there is one
+    if (buf1 == NULL) {
+      _dmx->frames[0] = (uint8_t*) malloc(sizeof(uint8_t) * 512);
+      _dmx->ownBuffer1 = 1;
+    } else {
+      _dmx->frames[0] = buf1;
+      _dmx->ownBuffer1 = 0;
+    }
+    _dmx->frames[1] = (uint8_t*) malloc(sizeof(uint8_t) * 512);
+    _dmx->frames[2] = (uint8_t*) malloc(sizeof(uint8_t) * 512);
+    for (uint8_t x = 0; x < 3; x++)
+      memset(_dmx->frames[x], 0, 512);
+
+    _dmx->frame_state = DMX_FRAME_STATE(0, 1, 2);
+    _dmx->data1 = _dmx->frames[2];
 
     _dmx->ownBuffer = 0;
 
@@ -417,16 +785,35 @@ void espDMX::begin(uint8_t dir, uint8_t* buf) {
 
     // Initialize variables
     _dmx->dmx_nr = _dmx_nr;
-    _dmx->txPin = (_dmx->dmx_nr == 0) ? 1 : 2;
+    _dmx->txPin = _txPin;
+    _dmx->rxPin = _rxPin;
+    _dmx->rmtChannel = _rmtChannel;
+    _dmx->rmtItems = NULL;
     _dmx->state = DMX_STOP;
     _dmx->txChan = 0;
+    _dmx->frame_time = 0;
+    _dmx->data_time = 0;
+    _dmx->frame_data_time = 0;
+    _dmx->frame_new = false;
+    memset(&_dmx->stats, 0, sizeof(dmx_stats));
+    _dmx->cpu_mhz = ets_get_cpu_frequency();
+    _dmx->break_ccount = 0;
+    _dmx->last_break_ccount = 0;
+    _dmx->brk_done_ccount = 0;
+    _dmx->last_period = 0;
     _dmx->full_uni_time = 0;
     _dmx->last_dmx_time = 0;
     _dmx->led_timer = 0;
     _dmx->newDMX = false;
     _dmx->started = false;
     _dmx->rdm_enable = false;
+    _dmx->rdm_in_use = false;
+    _dmx->rdm_break = false;
+    _dmx->rdm_timer = 0;
     _dmx->dirPin = dir;		// 255 is used to indicate no dir pin
+    vPortCPUInitializeMutex(&_dmx->mux);
+    dmx_set_timing(_dmx, &_timing);
+    _dmx->curves = &_curves;
 
     _dmx->rdmCallBack = NULL;
     _dmx->todCallBack = NULL;
@@ -434,9 +821,13 @@ void espDMX::begin(uint8_t dir, uint8_t* buf) {
     _dmx->inputCallBack = NULL;
 
 
-    // TX output set to idle
+    // TX output set to idle, then hand it to the UART or RMT which makes our breaks
     pinMode(_dmx->txPin, OUTPUT);
     digitalWrite(_dmx->txPin, HIGH);
+    if (_dmx->rmtChannel != DMX_RMT_NONE)
+      dmx_rmt_init(_dmx);
+    else
+      pinMatrixOutAttach(_dmx->txPin, UART_TXD_IDX(_dmx->dmx_nr), false, false);
 
     // Set direction to output
     if (_dmx->dirPin != 255) {
@@ -448,10 +839,111 @@ void espDMX::begin(uint8_t dir, uint8_t* buf) {
   if (_dmx) {
     dmx_set_buffer(_dmx, buf);
     dmx_clear_buffer(_dmx);
-    dmx_interrupt_enable(_dmx);
+    dmx_interrupt_enable(_dmx, this);
   }
 }
 
+void espDMX::setPins(uint8_t tx, uint8_t rx) {
+  _txPin = tx;
+  _rxPin = rx;
+}
+
+// Output on an RMT channel instead of our UART.  Output only - no RDM or DMX input.  Call before begin()
+void espDMX::setRMT(uint8_t channel) {
+  if (_dmx != 0 || channel >= RMT_CHANNEL_MAX)
+    return;
+
+  _rmtChannel = channel;
+}
+
+void espDMX::setTiming(const dmx_timing& timing) {
+  _timing = timing;
+
+  // Keep at least a valid break & MAB
+  if (_timing.breakBits < 23)
+    _timing.breakBits = 23;
+  if (_timing.mabBits < 2)
+    _timing.mabBits = 2;
+  if (_timing.minChans > 512)
+    _timing.minChans = 512;
+
+  dmx_set_timing(_dmx, &_timing);
+}
+
+void espDMX::setTiming(uint8_t profile) {
+  if (profile >= DMX_TIMING_PROFILES)
+    profile = DMX_TIMING_STANDARD;
+
+  setTiming(dmx_timing_profiles[profile]);
+}
+
+// Put num slots from start (0 based) through a response curve.  Replaces any curve those slots had
+bool espDMX::setCurve(uint16_t start, uint16_t num, uint8_t curve) {
+  if (curve >= DMX_CURVES || num == 0 || start >= 512)
+    return false;
+
+  uint16_t end = (start + num > 512) ? 512 : start + num;
+  const uint8_t* lut = dmx_curve_table(curve);
+
+  if (curve != DMX_CURVE_LINEAR && lut == 0)
+    return false;
+
+  // Cut the new range out of the ones we have, adding it in order.  Linear just leaves a gap
+  dmx_curves c;
+  bool added = (curve == DMX_CURVE_LINEAR);
+  c.num = 0;
+
+  for (uint8_t x = 0; x <= _curves.num; x++) {
+    bool last = (x == _curves.num);
+    dmx_curve_range r = last ? dmx_curve_range() : _curves.range[x];
+
+    // Part before the new range
+    if (!last && r.start < start) {
+      if (c.num >= DMX_MAX_CURVES)
+        return false;
+      c.range[c.num] = r;
+      if (r.end > start)
+        c.range[c.num].end = start;
+      c.num++;
+    }
+
+    // The new range goes before the first one that ends after it
+    if (!added && (last || r.end > end)) {
+      if (c.num >= DMX_MAX_CURVES)
+        return false;
+      c.range[c.num].start = start;
+      c.range[c.num].end = end;
+      c.range[c.num].curve = curve;
+      c.num++;
+      added = true;
+    }
+
+    // Part after the new range
+    if (!last && r.end > end) {
+      if (c.num >= DMX_MAX_CURVES)
+        return false;
+      c.range[c.num] = r;
+      if (r.start < end)
+        c.range[c.num].start = end;
+      c.num++;
+    }
+  }
+
+  _curves = c;
+
+  if (_dmx != 0 && _dmx->state != DMX_NOT_INIT && !_dmx->isInput)
+    dmx_new_data(_dmx);
+
+  return true;
+}
+
+void espDMX::clearCurves() {
+  _curves.num = 0;
+
+  if (_dmx != 0 && _dmx->state != DMX_NOT_INIT && !_dmx->isInput)
+    dmx_new_data(_dmx);
+}
+
 void espDMX::setBuffer(uint8_t* buf) {
   dmx_set_buffer(_dmx, buf);
 }
@@ -461,6 +953,10 @@ void espDMX::pause() {
 
   dmx_flush(_dmx);
 
+  // Hold RMT frames in handler() until unPause()
+  if (_dmx->rmtChannel != DMX_RMT_NONE)
+    _dmx->state = DMX_START;
+
   digitalWrite(_dmx->dirPin, HIGH);
 }
 
@@ -468,12 +964,10 @@ void espDMX::unPause() {
   if (_dmx == 0 || _dmx->state == DMX_NOT_INIT)
     return;
 
-  _dmx->newDMX = true;
   _dmx->state = DMX_STOP;
+  dmx_new_data(_dmx);
 
   digitalWrite(_dmx->dirPin, HIGH);
-
-  //dmx_transmit(_dmx);
 }
 
 void espDMX::end() {
@@ -489,10 +983,36 @@ void espDMX::end() {
 
 void espDMX::setChans(uint8_t *data, uint16_t numChans, uint16_t startChan) {
   dmx_set_chans(_dmx, data, numChans, startChan);
+  startFrame();
 }
 
 void espDMX::chanUpdate(uint16_t numChans) {
   dmx_buffer_update(_dmx, numChans);
+  startFrame();
+}
+
+void espDMX::getStats(dmx_stats* stats) {
+  if (_dmx == 0) {
+    memset(stats, 0, sizeof(dmx_stats));
+    return;
+  }
+
+  portENTER_CRITICAL(&_dmx->mux);
+  *stats = _dmx->stats;
+  portEXIT_CRITICAL(&_dmx->mux);
+
+  stats->fps = (stats->periodUs == 0) ? 0 : (1000000UL / stats->periodUs);
+}
+
+void espDMX::resetStats() {
+  if (_dmx == 0)
+    return;
+
+  portENTER_CRITICAL(&_dmx->mux);
+  memset(&_dmx->stats, 0, sizeof(dmx_stats));
+  _dmx->last_break_ccount = 0;
+  _dmx->last_period = 0;
+  portEXIT_CRITICAL(&_dmx->mux);
 }
 
 void espDMX::clearChans() {
@@ -500,6 +1020,7 @@ void espDMX::clearChans() {
     return;
 
   dmx_clear_buffer(_dmx);
+  dmx_new_data(_dmx);
 }
 
 uint8_t *espDMX::getChans() {
@@ -527,14 +1048,8 @@ void ICACHE_RAM_ATTR espDMX::_transmit(void) {
   // If we have data to transmit
   if (_dmx->txChan < _dmx->txSize) {
 
-    // Keep the number of uint8_ts sent low to keep it quick
-    //    uint16_t txSize = dmx->txSize - dmx->txChan;
-    //    txSize = (txSize > DMX_MAX_BYTES_PER_INT) ? DMX_MAX_BYTES_PER_INT : txSize;
-
-    //    for(; txSize; --txSize)
-    uart_dev_array[_dmx->dmx_nr]->fifo.rw_byte = _dmx->data1[_dmx->txChan++];
-
-    //    dmx_interrupt_arm(dmx);
+    // Top the FIFO up rather than a byte per interrupt
+    fillTX();
 
     // If all uint8_ts are transmitted
   } else {
@@ -544,7 +1059,16 @@ void ICACHE_RAM_ATTR espDMX::_transmit(void) {
 
     if (_dmx->state == DMX_TX) {
 
-      _dmx->state = DMX_STOP;
+      // RDM is run from handler() so give it a gap.  Go straight into the next frame if we want one by
+      // the time the FIFO is empty - otherwise new data or handler() will start it
+      uint32_t ahead = uart_dev_array[_dmx->dmx_nr]->status.txfifo_cnt * DMX_SLOT_US;
+
+      if ((_dmx->rdm_enable && !rdm_pause) || !dmx_frame_wanted(_dmx, ahead)) {
+        _dmx->state = DMX_STOP;
+      } else {
+        _dmxFrame();
+        dmx_break_start(_dmx);
+      }
 
     } else if (!rdm_pause) { // if (_dmx->state == RDM_TX) {
 
@@ -604,27 +1128,27 @@ bool espDMX::rdmSendCommand(uint8_t cmdClass, uint16_t pid, uint16_t manID, uint
   return rdmSendCommand(&command);
 }
 
-void espDMX::rdmReceived() {
+void ICACHE_RAM_ATTR espDMX::rdmReceived() {
   if (_dmx == 0 || _dmx->state != RDM_RX)
     return;
 
-  while (uart_dev_array[0]->status.rxfifo_cnt) {
-    _dmx->rdm_response.buffer[_dmx->rx_pos] = uart_dev_array[0]->fifo.rw_byte;
+  while (uart_dev_array[_dmx_nr]->status.rxfifo_cnt) {
+    _dmx->rdm_response.buffer[_dmx->rx_pos] = uart_dev_array[_dmx_nr]->fifo.rw_byte;
 
     // Handle multiple 0xFE to start discovery response
     if (_dmx->rx_pos == 1 && _dmx->rdm_response.buffer[0] == 0xFE && _dmx->rdm_response.buffer[1] == 0xFE)
       continue;
 
     // Handle break & MAB
-    if (rdmBreak || _dmx->rdm_response.buffer[0] == 0) {
+    if (_dmx->rdm_break || _dmx->rdm_response.buffer[0] == 0) {
       _dmx->rx_pos = 0;
-      rdmBreak = false;
+      _dmx->rdm_break = false;
       continue;
     }
     _dmx->rx_pos++;
   }
   // Clear interupt flags
-  uart_dev_array[0]->int_clr.val = 0xffffffff;
+  uart_dev_array[_dmx_nr]->int_clr.val = 0xffffffff;
 }
 
 void espDMX::rdmDiscovery(uint8_t discType) {
@@ -722,34 +1246,31 @@ void espDMX::rdmDiscoveryResponse(rdm_data* c) {
 
   // If we didn't get a valid response, split branch and try again
 
-  uint64_t m = 0;
-  uint64_t n = 0;
+  uint64_t l = 0;
   uint64_t e = 0;
 
-  // Get current end address
-  for (uint8_t x = 6; x < 12; x++)
-    e = (e << 8) | c->packet.Data[x];
-
-  // Calculate the midpoint & midpoint + 1
-  e = e << 16;
-  m = e >> 1;
-  n = m + 1;
+  // Get current start & end addresses
+  for (uint8_t x = 0; x < 6; x++) {
+    l = (l << 8) | c->packet.Data[x];
+    e = (e << 8) | c->packet.Data[x + 6];
+  }
 
   // Check if we're at the bottom branch
-  if (n == e) {
-    uint16_t a = __builtin_bswap16(e >> 32);
-    uint32_t b = __builtin_bswap32(e & 0xFFFFFFFF);
-
+  if (l >= e) {
     // Send mute command to check device is there & to mute from further discovery requests
-    rdmSendCommand(E120_DISCOVERY_COMMAND, E120_DISC_MUTE, a, b);
+    rdmSendCommand(E120_DISCOVERY_COMMAND, E120_DISC_MUTE, (uint16_t)(e >> 32), (uint32_t)(e & 0xFFFFFFFF));
 
     return;
   }
 
-  // Bitswap to fix endianess
-  m = __builtin_bswap64(m);
-  e = __builtin_bswap64(e);
-  n = __builtin_bswap64(n);
+  // Calculate the midpoint between the start & end & midpoint + 1
+  uint64_t m = l + ((e - l) >> 1);
+  uint64_t n = m + 1;
+
+  // Move the 48 bit UIDs to the top & bitswap to fix endianess
+  m = __builtin_bswap64(m << 16);
+  e = __builtin_bswap64(e << 16);
+  n = __builtin_bswap64(n << 16);
 
   // If we reach max queue size, wait for a bit and try again
   while (_dmx->rdm_queue.space() < 2) {
@@ -842,7 +1363,7 @@ void espDMX::rdmRXTimeout() {
     return;
 
   if (rdm_pause) {
-    rdm_interrupt_disarm();
+    rdm_interrupt_disarm(_dmx);
     dmx_flush(_dmx);
 
     _dmx->state = DMX_STOP;
@@ -853,12 +1374,14 @@ void espDMX::rdmRXTimeout() {
   }
 
   // Get remaining data
+  portENTER_CRITICAL(&_dmx->mux);
   rdmReceived();
+  portEXIT_CRITICAL(&_dmx->mux);
 
   _dmx->state = DMX_STOP;
   digitalWrite(_dmx->dirPin, HIGH);
 
-  rdm_interrupt_disarm();
+  rdm_interrupt_disarm(_dmx);
 
   rdm_data c;
   _dmx->rdm_queue.pop(&c);
@@ -883,7 +1406,7 @@ void espDMX::rdmRXTimeout() {
 }
 
 void espDMX::rdmEnable(uint16_t ManID, uint32_t DevID) {
-  if (_dmx == 0 || _dmx->dirPin == 255 || dmx_input)
+  if (_dmx == 0 || _dmx->dirPin == 255 || _dmx->isInput || _dmx->rmtChannel != DMX_RMT_NONE)
     return;
 
 
@@ -905,8 +1428,8 @@ void espDMX::rdmEnable(uint16_t ManID, uint32_t DevID) {
   // Setup direction pin
   digitalWrite(_dmx->dirPin, HIGH);
 
-  // Enable RX pin (same for both universes)
-  pinMode(3, SPECIAL);
+  // Enable our RX pin
+  dmx_rx_attach(_dmx);
 
   _dmx->rdm_source_man = ManID;
   _dmx->rdm_source_dev = DevID;
@@ -918,8 +1441,8 @@ void espDMX::rdmDisable() {
   if (_dmx == 0)
     return;
 
-  if (rdmInUse && rxUser == _dmx->dmx_nr) {
-    rdmInUse = false;
+  if (_dmx->rdm_in_use) {
+    rdm_interrupt_disarm(_dmx);
     _dmx->state = DMX_STOP;
   }
 
@@ -993,42 +1516,50 @@ bool espDMX::rdmEnabled() {
 }
 
 void rdmPause(bool p) {
-  if (dmx_input && p == false)
-    return;
+  espDMX* ports[3] = { &dmxA, &dmxB, &dmxC };
 
   rdm_pause = p;
 
-  if (p) {
-    if (rdmInUse) {
-      if (rxUser == 0)
-        dmxA.rdmRXTimeout();
-      else
-        dmxB.rdmRXTimeout();
+  for (uint8_t x = 0; x < 3; x++) {
+    dmx_t* dmx = ports[x]->_dmx;
+
+    if (dmx == 0)
+      continue;
+
+    if (p) {
+      if (dmx->rdm_in_use)
+        ports[x]->rdmRXTimeout();
+      dmx->rdm_in_use = false;
+    } else {
+      ports[x]->rdmDiscovery(RDM_DISCOVERY_FULL);
     }
-    rdmInUse = false;
-  } else {
-    dmxA.rdmDiscovery(RDM_DISCOVERY_FULL);
-    dmxB.rdmDiscovery(RDM_DISCOVERY_FULL);
   }
 }
 
 
 void espDMX::dmxIn(bool doIn) {
-  if (_dmx == 0)
+  if (_dmx == 0 || _dmx->rmtChannel != DMX_RMT_NONE)
     return;
 
   if (doIn) {
+    if (!_dmx->isInput)
+      _dmx->outData = _dmx->data;
     _dmx->isInput = true;
 
-    // Clear our buffers
+    // Clear our buffers.  data1 might be pointing at a queued RDM packet
+    _dmx->data1 = _dmx->frames[DMX_FRAME_TX(_dmx->frame_state)];
     memset(_dmx->data, 0, 512);
     memset(_dmx->data1, 0, 512);
 
     dmx_interrupt_disarm(_dmx);
-    rdmPause(true);
+
+    // No RDM on an input - or on any port listening to the same RX pin
+    rdmDisable();
+    if (rxPinShared())
+      rdmPause(true);
 
     // Turn RX pin into UART mode
-    pinMode(3, SPECIAL);
+    dmx_rx_attach(_dmx);
 
     // If dirPin is specified then set to in direction
     if (_dmx->dirPin != 255) {
@@ -1039,59 +1570,75 @@ void espDMX::dmxIn(bool doIn) {
     // Set txPin to idle
     digitalWrite(_dmx->txPin, HIGH);
 
-    dmx_input = true;
-    rxUser = _dmx->dmx_nr;
     _dmx->state = DMX_RX_IDLE;
 
-    noInterrupts();
-
-    uint32_t clk_div = ((getApbFrequency() << 4) / DMX_TX_BAUD);
-    uart_dev_array[0]->clk_div.div_int = clk_div >> 4 ;
-    uart_dev_array[0]->clk_div.div_frag = clk_div & 0xf;
-
-    // set to 8N2
-    uart_dev_array[0]->conf0.parity = 0;
-    uart_dev_array[0]->conf0.parity_en = 0;
-    uart_dev_array[0]->conf0.bit_num = 3;
-    uart_dev_array[0]->conf0.stop_bit_num = 3;
+    // Baud rate & 8N2 are already set up by begin()
+    portENTER_CRITICAL(&_dmx->mux);
 
-    uart_dev_array[0]->conf1.rxfifo_full_thrhd = 1;
+    memset(&_dmx->stats, 0, sizeof(dmx_stats));
+    _dmx->break_ccount = 0;
+    _dmx->last_break_ccount = 0;
+    _dmx->last_period = 0;
 
-    rx_flush();                   // flush rx buffer
+    // Drain the FIFO in bursts, with the RX timeout picking up the tail of short frames
+    uart_dev_array[_dmx_nr]->conf1.rxfifo_full_thrhd = DMX_RX_FIFO_THRESHOLD;
+    uart_dev_array[_dmx_nr]->conf1.rx_tout_thrhd = DMX_RX_TIMEOUT;
+    uart_dev_array[_dmx_nr]->conf1.rx_tout_en = 1;
+    _dmx->rx_pos = 0;
 
-    uart_dev_array[0]->int_clr.val = 0xffffffff;
+    rx_flush(_dmx);               // flush rx buffer
 
-    // Enable RX Fifo Full, Break Detect & Frame Error Interupts
-    uart_dev_array[0]->int_ena.rxfifo_full = 1;
-    uart_dev_array[0]->int_ena.brk_det = 1;
-    uart_dev_array[0]->int_ena.frm_err = 1;
+    uart_dev_array[_dmx_nr]->int_clr.val = 0xffffffff;
 
-    esp_intr_alloc(UART_INTR_SOURCE(0), (int)ESP_INTR_FLAG_IRAM, (void (*)(void *))&dmx_interrupt_handler, NULL, &uart_intr_handle[0]);
+    // Enable RX Fifo Full, RX Timeout, Break Detect & Frame Error Interupts
+    uart_dev_array[_dmx_nr]->int_ena.rxfifo_full = 1;
+    uart_dev_array[_dmx_nr]->int_ena.rxfifo_tout = 1;
+    uart_dev_array[_dmx_nr]->int_ena.brk_det = 1;
+    uart_dev_array[_dmx_nr]->int_ena.frm_err = 1;
 
-    interrupts();
+    portEXIT_CRITICAL(&_dmx->mux);
 
   } else {
-    // Disable RX Fifo Full, Break Detect & Frame Error Interupts
-    uart_dev_array[0]->int_ena.rxfifo_full = 0;
-    uart_dev_array[0]->int_ena.brk_det = 0;
-    uart_dev_array[0]->int_ena.frm_err = 0;
+    // Disable RX Fifo Full, RX Timeout, Break Detect & Frame Error Interupts
+    uart_dev_array[_dmx_nr]->int_ena.rxfifo_full = 0;
+    uart_dev_array[_dmx_nr]->int_ena.rxfifo_tout = 0;
+    uart_dev_array[_dmx_nr]->conf1.rx_tout_en = 0;
+    uart_dev_array[_dmx_nr]->int_ena.brk_det = 0;
+    uart_dev_array[_dmx_nr]->int_ena.frm_err = 0;
 
     if (_dmx->dirPin != 255) {
       pinMode(_dmx->dirPin, OUTPUT);
       digitalWrite(_dmx->dirPin, HIGH);
     }
 
-    // Clear output buffer & reset channel count
+    // Clear output frames & reset channel count
+    if (_dmx->isInput)
+      _dmx->data = _dmx->outData;
     memset(_dmx->data, 0, 512);
-    memset(_dmx->data1, 0, 512);
+    for (uint8_t x = 0; x < 3; x++)
+      memset(_dmx->frames[x], 0, 512);
+    _dmx->frame_state = DMX_FRAME_STATE(0, 1, 2);
+    _dmx->data1 = _dmx->frames[2];
     _dmx->numChans = 0;
 
     _dmx->isInput = false;
-    dmx_input = false;
-    rdmPause(false);
+    _dmx->state = DMX_STOP;
+
+    if (rxPinShared())
+      rdmPause(false);
   }
 }
 
+bool espDMX::rxPinShared() {
+  espDMX* ports[3] = { &dmxA, &dmxB, &dmxC };
+
+  for (uint8_t x = 0; x < 3; x++) {
+    if (ports[x] != this && ports[x]->_dmx != 0 && ports[x]->_dmx->rxPin == _dmx->rxPin)
+      return true;
+  }
+  return false;
+}
+
 void espDMX::setInputCallback(inputCallBackFunc callback) {
   if (_dmx == 0)
     return;
@@ -1099,37 +1646,88 @@ void espDMX::setInputCallback(inputCallBackFunc callback) {
   _dmx->inputCallBack = callback;
 }
 
-void ICACHE_RAM_ATTR espDMX::dmxReceived(uint8_t c) {
-  switch ( _dmx->state ) {
-    case DMX_RX_BREAK:
-      if ( c == 0 ) {                     //start code == zero (DMX)
-        _dmx->state = DMX_RX_DATA;
-        _dmx->numChans = _dmx->rx_pos;
-        _dmx->rx_pos = 0;
-      } else {
-        _dmx->state = DMX_RX_IDLE;
-      }
-      break;
+// Move what's waiting in the RX FIFO into the back buffer.  After a break the last byte is the break's null.
+// idle is set when the RX timeout went off, so the last byte came in DMX_RX_TIMEOUT slots ago
+void ICACHE_RAM_ATTR espDMX::dmxReceived(bool brk, bool idle) {
+  uart_dev_t* uart = uart_dev_array[_dmx_nr];
+  uint16_t n = uart->status.rxfifo_cnt;
+  uint16_t pos = _dmx->rx_pos;
+  uint8_t nul = 0;
+
+  if (brk && n != 0) {
+    n--;
+    nul = 1;
+  }
 
-    case DMX_RX_DATA:
-      _dmx->data1[_dmx->rx_pos++] = c;
-      if ( _dmx->rx_pos >= 512 ) {
-        _dmx->state = DMX_RX_IDLE;      // go to idle, wait for next break
-      }
-      break;
+  // Start code.  It ended n - 1 slots before the last byte, if the slots came back to back
+  if (n != 0 && _dmx->state == DMX_RX_BREAK) {
+    uint32_t sc = dmx_ccount() - (n - 1 + (idle ? DMX_RX_TIMEOUT : 0)) * DMX_SLOT_US * _dmx->cpu_mhz;
+
+    n--;
+    if ((uint8_t)uart->fifo.rw_byte == 0) {     //start code == zero (DMX)
+      _dmx->state = DMX_RX_DATA;
+      // Break flagged to start code end is the break & MAB, as each is a slot late
+      if (_dmx->break_ccount != 0 && (int32_t)(sc - _dmx->break_ccount) > 0)
+        _dmx->stats.breakUs = (sc - _dmx->break_ccount) / _dmx->cpu_mhz;
+    } else {
+      _dmx->state = DMX_RX_IDLE;
+      _dmx->stats.startCodes++;
+    }
+  }
+
+  if (n != 0 && _dmx->state == DMX_RX_DATA) {
+    uint16_t c = 512 - pos;
+    if (n < c)
+      c = n;
+    n -= c;
+
+    uint8_t* d = &_dmx->data1[pos];
+    pos += c;
+    while (c--)
+      *d++ = uart->fifo.rw_byte;
+
+    if (pos >= 512)
+      _dmx->state = DMX_RX_IDLE;      // go to idle, wait for next break
   }
+
+  // Not DMX or past slot 512 - and the break's null
+  n += nul;
+  while (n--)
+    (void)(uint8_t)uart->fifo.rw_byte;
+
+  _dmx->rx_pos = pos;
 }
 
 void ICACHE_RAM_ATTR espDMX::inputBreak(void) {
   if (_dmx == 0)
     return;
 
+  // The break is flagged once its first slot time has gone
+  uint32_t now = dmx_ccount();
+
+  if (_dmx->last_break_ccount != 0 && (now - _dmx->last_break_ccount) / _dmx->cpu_mhz < DMX_RX_MIN_PERIOD)
+    _dmx->stats.shortFrames++;
+  dmx_break_stats(_dmx, now);
+  _dmx->break_ccount = now;
+
   _dmx->state = DMX_RX_BREAK;
 
+  // Nothing since the last break - not a DMX frame
+  if (_dmx->rx_pos == 0)
+    return;
+
+  _dmx->numChans = _dmx->rx_pos;
+  _dmx->rx_pos = 0;
+
+  _dmx->stats.frames++;
+  _dmx->stats.slots = _dmx->numChans + 1;
+  _dmx->stats.lastFrame = millis();
+  _dmx->stats.frameCcount = now;
+
   // Double buffer switch
   uint8_t* tmp = _dmx->data;
   _dmx->data = _dmx->data1;
-  _dmx->data1 = _dmx->data;
+  _dmx->data1 = tmp;
 
   if (_dmx->inputCallBack)
     _dmx->inputCallBack(_dmx->numChans);
@@ -1140,8 +1738,13 @@ void espDMX::handler() {
   if (_dmx == 0 || _dmx->state == DMX_NOT_INIT)
     return;
 
+  if (_dmx->rmtChannel != DMX_RMT_NONE) {
+    rmtHandler();
+    return;
+  }
+
   // Check if RDM reply should be finished yet
-  if (rdmInUse && rxUser == _dmx->dmx_nr && rdmTimer < micros())
+  if (_dmx->rdm_in_use && (long)(micros() - _dmx->rdm_timer) > 0)
     rdmRXTimeout();
 
   // If DMX is in use then we don't need to proceed
@@ -1151,8 +1754,9 @@ void espDMX::handler() {
 
   dmx_interrupt_disarm(_dmx);
 
-  // Check if we need to do RDM
-  if (!rdm_pause && _dmx->rdm_enable && !rdmInUse) {
+  // Check if we need to do RDM.  One RDM transaction at most between DMX frames, so once RDM has had the
+  // line a frame that's due always goes next & is only ever held back by one request & its reply
+  if (!rdm_pause && _dmx->rdm_enable && !_dmx->rdm_in_use && (!_dmx->started || _dmx->rdm_turn)) {
 
     // If we haven't finished our TOD, this will check for any remaining devices
     // or if it's a while since RDM, continue with incremental discovery
@@ -1161,77 +1765,149 @@ void espDMX::handler() {
 
 
     // Send RDM if there is any
-    noInterrupts();
+    portENTER_CRITICAL(&_dmx->mux);
     if (! _dmx->rdm_queue.isEmpty()) {
-      rdmInUse = true;
-      rx_flush();
+      _dmx->rdm_in_use = true;
+      rx_flush(_dmx);
 
       rdm_data* c = _dmx->rdm_queue.peek();
       _dmx->txSize = c->buffer[2] + 3;	// Extra uint8_t added so we don't need a delay in the interrupt
 
-      memcpy(_dmx->data1, c->buffer, _dmx->txSize - 1);
+      // Sent straight from the queue, which keeps it until the reply or timeout.  Leaves our frames alone
+      _dmx->data1 = c->buffer;
 
+      if (_dmx->started && dmx_frame_wanted(_dmx, 0))
+        _dmx->stats.rdmPreempted++;
+
+      _dmx->rdm_turn = false;
       _dmx->state = RDM_START;
     }
-    interrupts();
+    portEXIT_CRITICAL(&_dmx->mux);
 
   }
 
-  // If not RDM then do DMX_START
-  if (_dmx->state == DMX_STOP && _dmx->started) {
+  // If not RDM then do DMX_START when there is new data or the keepalive is up.  Frames then follow
+  // each other from the interrupt for as long as that holds
+  portENTER_CRITICAL(&_dmx->mux);
+  if (_dmx->state == DMX_STOP && _dmx->started && dmx_frame_wanted(_dmx, 0))
+    _dmxFrame();
+  portEXIT_CRITICAL(&_dmx->mux);
 
-    // If no new DMX and we're not needing to send a full universe then exit
-    //if (millis() < _dmx->full_uni_time && !_dmx->newDMX)
-    //  return;
+  if (_dmx->state == DMX_STOP)
+    return;
 
-    // DMX Transmit
-    if (millis() >= _dmx->full_uni_time)
-      _dmx->txSize = 512;
-    else
-      _dmx->txSize = _dmx->numChans;
+  // RDM reply timeout starts now so it can't run out before our break
+  if (_dmx->state == RDM_START)
+    _dmx->rdm_timer = micros() + 5000;
 
-    // If we are sending a full universe then reset the timer
-    if (_dmx->txSize == 512)
-      _dmx->full_uni_time = millis() + DMX_FULL_UNI_TIMING;
+  // The UART sends the break & MAB after the last slot has gone, then _breakDone() starts the frame
+  dmx_break_start(_dmx);
+}
 
-    // Copy data into the tx buffer
-    memcpy(_dmx->data1, _dmx->data, _dmx->txSize);
+// RMT frames are encoded here & sent by the RMT with no CPU until the next frame
+void espDMX::rmtHandler(void) {
+  rmt_channel_t channel = (rmt_channel_t)_dmx->rmtChannel;
 
-    _dmx->state = DMX_START;
+  if (_dmx->rmtItems == NULL)
+    return;
+
+  // The RMT reads our items as it goes so wait for the last frame to finish
+  if (_dmx->state == DMX_TX) {
+    if (rmt_wait_tx_done(channel, 0) != ESP_OK)
+      return;
+    _dmx->state = DMX_STOP;
   }
 
-  if (_dmx->state == DMX_STOP)
+  if (_dmx->state != DMX_STOP || !_dmx->started || !dmx_frame_wanted(_dmx, 0))
     return;
 
-  // Wait for empty FIFO
-  while (uart_dev_array[_dmx->dmx_nr]->status.txfifo_cnt != 0) {
-    yield();
+  portENTER_CRITICAL(&_dmx->mux);
+  _dmxFrame();
+  portEXIT_CRITICAL(&_dmx->mux);
+
+  uint16_t n = dmx_rmt_encode(_dmx, _dmx->txSize);
+
+  _dmx->state = DMX_TX;
+  _dmx->last_dmx_time = millis();
+  _dmx->frame_time = micros();
+
+  rmt_write_items(channel, _dmx->rmtItems, n, false);
+
+  // The RMT times the break & MAB exactly.  Start code follows them
+  portENTER_CRITICAL(&_dmx->mux);
+  _dmx->stats.breakUs = _dmx->timing.breakBits * 4;
+  _dmx->stats.mabUs = _dmx->timing.mabBits * 4;
+  dmx_break_stats(_dmx, dmx_ccount());
+  dmx_frame_stats(_dmx, micros() + (_dmx->timing.breakBits + _dmx->timing.mabBits) * 4);
+  portEXIT_CRITICAL(&_dmx->mux);
+}
+
+// New data starts a frame straight away if the port is idle rather than waiting for handler()
+void espDMX::startFrame(void) {
+  if (_dmx == 0 || _dmx->state == DMX_NOT_INIT)
+    return;
+
+  if (_dmx->rmtChannel != DMX_RMT_NONE) {
+    rmtHandler();
+    return;
   }
 
-  // Allow last channel to be fully sent
-  delayMicroseconds(44);
+  if (_dmx->state != DMX_STOP)
+    return;
+
+  portENTER_CRITICAL(&_dmx->mux);
+  bool start = (_dmx->state == DMX_STOP && _dmx->started && !_dmx->rdm_in_use && dmx_frame_wanted(_dmx, 0));
+  if (start)
+    _dmxFrame();
+  portEXIT_CRITICAL(&_dmx->mux);
+
+  if (start)
+    dmx_break_start(_dmx);
+}
 
-  // BREAK of ~120us
-  pinMode(_dmx->txPin, OUTPUT);
-  digitalWrite(_dmx->txPin, LOW);
-  delayMicroseconds(118);
+// Pick up the next frame.  data1 is free once the last frame is in the FIFO
+void ICACHE_RAM_ATTR espDMX::_dmxFrame(void) {
+  // Send a full universe every so often
+  if ((long)(millis() - _dmx->full_uni_time) >= 0) {
+    _dmx->txSize = 512;
+    _dmx->full_uni_time = millis() + _dmx->timing.fullUniTime;
+  } else {
+    _dmx->txSize = (_dmx->numChans < _dmx->timing.minChans) ? _dmx->timing.minChans : _dmx->numChans;
+  }
 
-  // MAB of ~12us
-  digitalWrite(_dmx->txPin, HIGH);
-  delayMicroseconds(7);
+  // Latest complete frame.  Data published from here on is for the next frame
+  dmx_frame_take(_dmx);
+  _dmx->stats.slots = _dmx->txSize + 1;
 
-  // Change pin to UART mode
-  pinMode(_dmx->txPin, SPECIAL);
+  _dmx->frame_new = _dmx->newDMX;
+  _dmx->frame_data_time = _dmx->data_time;
+  _dmx->newDMX = false;
 
-  // Empty FIFO
-  dmx_flush(_dmx);
+  _dmx->state = DMX_START;
+}
+
+void ICACHE_RAM_ATTR espDMX::_breakDone(void) {
+  uart_dev_array[_dmx->dmx_nr]->conf0.txd_brk = 0;
+  uart_dev_array[_dmx->dmx_nr]->int_ena.tx_brk_done = 0;
 
   if (_dmx->state == DMX_START) {
 
-    _dmx->newDMX = false;
     _dmx->state = DMX_TX;
     _dmx->last_dmx_time = millis();
+    _dmx->frame_time = micros();
     _dmx->txChan = 0;
+    _dmx->rdm_turn = true;
+
+    // Measure the break & then the MAB when the UART tells us it's done
+    _dmx->brk_done_ccount = dmx_ccount();
+    if (_dmx->break_ccount != 0) {
+      _dmx->stats.breakUs = (_dmx->brk_done_ccount - _dmx->break_ccount) / _dmx->cpu_mhz;
+      dmx_break_stats(_dmx, _dmx->break_ccount);
+    }
+    uart_dev_array[_dmx->dmx_nr]->int_clr.tx_brk_idle_done = 1;
+    uart_dev_array[_dmx->dmx_nr]->int_ena.tx_brk_idle_done = 1;
+
+    dmx_frame_stats(_dmx, _dmx->frame_time);
 
     // Set TX Fifo Empty trigger point
     uart_dev_array[_dmx->dmx_nr]->conf1.txfifo_empty_thrhd = 50;
@@ -1242,7 +1918,6 @@ void espDMX::handler() {
   } else if (_dmx->state == RDM_START) {
 
     _dmx->state = RDM_TX;
-    rdmTimer = micros() + 5000;
     _dmx->txChan = 1;		// start code is already in the buffer
 
     // Set TX Fifo empty trigger point & RX Fifo full threshold
@@ -1251,12 +1926,15 @@ void espDMX::handler() {
 
     // RDM Start Code 0xCC
     uart_dev_array[_dmx->dmx_nr]->fifo.rw_byte = 0xCC;
+
+  } else {
+    return;
   }
 
   fillTX();
 }
 
-void espDMX::fillTX(void) {
+void ICACHE_RAM_ATTR espDMX::fillTX(void) {
   uint16_t fifoRoom = dmx_get_tx_fifo_room(_dmx) - 3;
 
   uint16_t txSize = _dmx->txSize - _dmx->txChan;
@@ -23,7 +23,21 @@
 #define DMX_NO_LED            200
 #define DMX_MIN_CHANS         30     	// Minimum channels output = this + DMX_ADD_CHANS
 #define DMX_ADD_CHANS         30     	// Add extra buffer to the number of channels output
+#define DMX_KEEPALIVE         25        // Longest gap between unchanged frames (in milliseconds)
 #define UART_TX_FIFO_SIZE     0x80
+#define DMX_TX_BREAK_BITS     30      // Default break length in bit times (4us each) - sent by the UART
+#define DMX_TX_MAB_BITS       3       // Default mark after break in bit times
+#define DMX_SLOT_US           44      // One 8N2 slot at 250kbaud
+#define DMX_JITTER_BUCKETS    8       // <8us, <32us, <128us ... each 4x the last, then the rest
+#define DMX_MAX_CURVES        16      // Slot ranges with a response curve per port
+#define DMX_RX_FIFO_THRESHOLD 64      // Input bytes gathered in the RX FIFO before interrupting
+#define DMX_RX_TIMEOUT        3       // Idle byte times before the RX FIFO is drained anyway
+#define DMX_RX_MIN_PERIOD     1196    // Shortest break to break E1.11 has receivers accept (in microseconds)
+
+#define DMX_RMT_NONE          255
+#define DMX_RMT_CLK_DIV       80      // 80MHz APB / 80 = 1us RMT ticks
+#define DMX_RMT_BIT_TICKS     4       // 250kbaud
+#define DMX_RMT_ITEMS         (1 + 513 * 5)   // Break & MAB, then at most 5 items per 8N2 slot
 
 #define RDM_DISCOVERY_INC_TIME    700       // How often to run incremental discovery
 #define RDM_DISCOVERY_INCREMENTAL 0
@@ -34,6 +48,8 @@
 #include "rdmDataTypes.h"
 #include "rdmFIFO.h"
 
+#include "driver/rmt.h"
+
 typedef void (*rdmCallBackFunc)(rdm_data*);
 typedef void (*todCallBackFunc)(void);
 typedef void (*inputCallBackFunc)(uint16_t);
@@ -52,6 +68,71 @@ enum dmx_state {
   DMX_RX_IDLE
 };
 
+// Timing profiles - see dmx_timing_profiles
+enum dmx_timing_profile {
+  DMX_TIMING_STANDARD,
+  DMX_TIMING_TURBO,     // Spec minimum: short universes at up to 830Hz
+  DMX_TIMING_SAFE,      // Long break & slot gaps, full universe at 40Hz for fussy fixtures
+  DMX_TIMING_PROFILES
+};
+
+struct dmx_timing {
+  uint8_t breakBits;        // Bit times (4us each)
+  uint8_t mabBits;
+  uint8_t slotGap;          // Extra mark bits after each slot.  UARTs can only do 0 or 1
+  uint16_t minChans;        // Minimum slots per frame
+  uint16_t addChans;        // Slots sent past the highest one with data
+  uint16_t maxRefresh;      // Frames per second, 0 for as fast as possible
+  uint16_t keepAlive;       // Longest gap between frames when there's no new data (in milliseconds), 0 to free run
+  uint16_t fullUniTime;     // How often to send all 512 slots (in milliseconds)
+};
+
+// Response curves, applied through a 256 entry table as frames are handed to the transmitter
+enum dmx_curve {
+  DMX_CURVE_LINEAR,
+  DMX_CURVE_SQUARE,     // Square law
+  DMX_CURVE_SCURVE,     // Smoothstep - slow at both ends
+  DMX_CURVE_ROOT,       // Inverse square law
+  DMX_CURVE_INVERT,     // 255 - value
+  DMX_CURVES
+};
+
+struct dmx_curve_range {
+  uint16_t start;
+  uint16_t end;             // One past the last slot
+  uint8_t curve;
+};
+
+// Kept sorted by start with no overlaps
+struct dmx_curves {
+  uint8_t num;
+  dmx_curve_range range[DMX_MAX_CURVES];
+};
+
+struct dmx_stats {
+  uint32_t frames;
+  uint32_t keepAlives;      // Frames sent with no new data
+  uint32_t rdmPreempted;    // Due frames held back for the one RDM transaction between frames
+  uint32_t latency;         // New data to start code on the wire (in microseconds)
+  uint32_t latencyMax;
+  uint32_t latencyAvg;      // Smoothed over about 8 frames
+
+  // Measured on the wire with the cycle counter (in microseconds)
+  uint16_t slots;           // Last frame, including the start code
+  uint32_t breakUs;
+  uint32_t mabUs;
+  uint32_t periodUs;        // Break to break, smoothed over about 8 frames
+  uint32_t fps;             // From periodUs - filled in by getStats()
+  unsigned long lastFrame;  // millis() of the last frame
+  uint32_t jitter[DMX_JITTER_BUCKETS];  // Change in break to break time between frames
+
+  // DMX input.  breakUs is the break & MAB together as the UART doesn't see where the break ends
+  uint32_t frameCcount;     // Cycle count at the break that ended the last frame
+  uint32_t frameErrors;     // Framing errors that weren't breaks
+  uint32_t shortFrames;     // Break to break under DMX_RX_MIN_PERIOD
+  uint32_t startCodes;      // Frames with a start code other than 0
+};
+
 union uint8_t_uint64 {
   uint8_t b[8];
   uint64_t u;
@@ -61,7 +142,9 @@ union uint8_t_uint64 {
 struct dmx_ {
   uint8_t dmx_nr;
   uint8_t txPin;
+  uint8_t rxPin;
   uint8_t dirPin;
+  uint8_t rmtChannel;
   uint8_t ledIntensity;
   uint8_t state = DMX_NOT_INIT;
 
@@ -69,6 +152,23 @@ struct dmx_ {
   uint16_t txChan;
   uint16_t txSize;
 
+  dmx_timing timing;
+  uint32_t frame_us;        // Minimum break to break time from timing.maxRefresh
+  uint32_t keepalive_us;
+  unsigned long frame_time;
+
+  unsigned long data_time;  // When newDMX was set
+  unsigned long frame_data_time;
+  bool frame_new = false;   // The frame being sent has new data
+  dmx_stats stats;
+
+  // Cycle counts for the timing stats.  break_ccount is 0 until the UART has gone idle
+  uint32_t cpu_mhz;
+  uint32_t break_ccount;
+  uint32_t last_break_ccount;
+  uint32_t brk_done_ccount;
+  uint32_t last_period;
+
   long full_uni_time;
   long last_dmx_time;
   long led_timer;
@@ -76,13 +176,26 @@ struct dmx_ {
   bool started = false;
 
   uint8_t* data;
-  uint8_t* data1;
+  uint8_t* data1;           // Frame being sent or received
   bool ownBuffer = 0;
+  bool ownBuffer1 = 0;
+
+  // Triple buffer between data & the transmitter.  frames[0] is the buffer given to begin()
+  uint8_t* frames[3];
+  volatile uint32_t frame_state;
+  const dmx_curves* curves; // Applied as data is copied into frames
+
+  rmt_item32_t* rmtItems = NULL;
 
   bool isInput = false;
+  uint8_t* outData;         // data from before dmxIn() - input frames swap data & data1 round
   inputCallBackFunc inputCallBack = NULL;
 
   bool rdm_enable = false;
+  bool rdm_in_use = false;
+  bool rdm_turn = true;     // A DMX frame has gone since the last RDM transaction
+  bool rdm_break = false;
+  unsigned long rdm_timer = 0;
   rdmFIFO rdm_queue;
   rdm_data rdm_response;
   uint16_t rx_pos = 0;
@@ -100,6 +213,8 @@ struct dmx_ {
 
   rdmCallBackFunc rdmCallBack = NULL;
   todCallBackFunc todCallBack = NULL;
+
+  portMUX_TYPE mux;
 };
 typedef struct dmx_ dmx_t;
 
@@ -108,7 +223,10 @@ class espDMX {
     espDMX(uint8_t dmx_nr);
     ~espDMX();
 
-    void begin(uint8_t dir, uint8_t* buf);
+    void begin(uint8_t dir, uint8_t* buf, uint8_t* buf1);
+    void begin(uint8_t dir, uint8_t* buf) {
+      begin(dir, buf, NULL);
+    };
     void begin(uint8_t dir) {
       begin(dir, NULL);
     };
@@ -119,6 +237,17 @@ class espDMX {
       begin(255, NULL);
     };
 
+    void setPins(uint8_t tx, uint8_t rx);
+    void setRMT(uint8_t channel);
+    void setTiming(const dmx_timing& timing);
+    void setTiming(uint8_t profile);
+    bool setCurve(uint16_t start, uint16_t num, uint8_t curve);
+    void clearCurves(void);
+    void getStats(dmx_stats* stats);
+    void resetStats(void);
+    dmx_timing getTiming(void) {
+      return _timing;
+    };
     void setBuffer(uint8_t*);
     void setBuffer(void) {
       setBuffer(NULL);
@@ -186,18 +315,21 @@ class espDMX {
     void setInputCallback(void (*inputCallBackFunc)(uint16_t));
 
   private:
-    friend void dmx_interrupt_handler(void);
-    friend void rdm_timer_handler(void);
-    friend void rdm_interrupt_disarm(dmx_t* dmx);
+    friend void dmx_interrupt_handler(void*);
     friend void rdmPause(bool);
 
     void _transmit(void);
+    void _breakDone(void);
+    void _dmxFrame(void);
     void fillTX(void);
+    void rmtHandler(void);
+    void startFrame(void);
 
     void inputBreak(void);
-    void dmxReceived(uint8_t);
+    void dmxReceived(bool brk, bool idle);
 
     void rdmRXTimeout(void);
+    bool rxPinShared(void);
     void rdmBreakDetect(void);
 
     void rdmReceived(void);
@@ -212,11 +344,17 @@ class espDMX {
     };
 
     uint8_t _dmx_nr;
+    uint8_t _txPin;
+    uint8_t _rxPin;
+    uint8_t _rmtChannel;
+    dmx_timing _timing;
+    dmx_curves _curves;
     dmx_t* _dmx;
 };
 
 
 extern espDMX dmxA;
 extern espDMX dmxB;
+extern espDMX dmxC;
 extern void rdmPause(bool);
 #endif
@@ -0,0 +1,151 @@
+/*
+  espDMX host model
+  Just enough of the ESP32 Arduino core for espDMX_RDM.cpp & espArtNetRDM.cpp, backed by uartModel
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uartModel.h"
+#include "WString.h"
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+#define LOW     0
+#define HIGH    1
+#define INPUT   0x01
+#define OUTPUT  0x02
+
+typedef int esp_err_t;
+#define ESP_OK          0
+#define ESP_ERR_TIMEOUT 0x107
+#define portMAX_DELAY   0xffffffff
+
+// The simulation is single threaded & interrupts only run between steps, so the spinlocks have
+// nothing to do
+typedef struct {
+  uint32_t owner;
+} portMUX_TYPE;
+
+#define portENTER_CRITICAL(m)     ((void)(m))
+#define portEXIT_CRITICAL(m)      ((void)(m))
+#define portENTER_CRITICAL_ISR(m) ((void)(m))
+#define portEXIT_CRITICAL_ISR(m)  ((void)(m))
+
+static inline void vPortCPUInitializeMutex(portMUX_TYPE* mux) {
+  mux->owner = 0;
+}
+
+static inline void uxPortCompareSet(volatile uint32_t* addr, uint32_t compare, uint32_t* set) {
+  uint32_t old = *addr;
+
+  if (old == compare)
+    *addr = *set;
+  *set = old;
+}
+
+typedef void* intr_handle_t;
+#define ESP_INTR_FLAG_IRAM    (1 << 10)
+#define ETS_UART0_INTR_SOURCE 34
+#define ETS_UART1_INTR_SOURCE 35
+#define ETS_UART2_INTR_SOURCE 36
+
+#define U0RXD_IN_IDX  14
+#define U0TXD_OUT_IDX 14
+#define U1RXD_IN_IDX  17
+#define U1TXD_OUT_IDX 17
+#define U2RXD_IN_IDX  198
+#define U2TXD_OUT_IDX 198
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+static inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+  return malloc(size);
+}
+
+static inline uint32_t system_get_free_heap_size(void) {
+  return 100000;
+}
+
+static inline unsigned long micros(void) {
+  return host_micros();
+}
+
+static inline unsigned long millis(void) {
+  return host_millis();
+}
+
+static inline void yield(void) {
+}
+
+static inline void delay(uint32_t ms) {
+  for (uint32_t x = 0; x < ms * 1000; x++)
+    host_step();
+}
+
+// newlib has strlcpy, older glibc doesn't
+static inline size_t host_strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+
+  if (size != 0) {
+    size_t n = (len < size - 1) ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
+#define strlcpy host_strlcpy
+
+static inline void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+static inline void digitalWrite(uint8_t pin, uint8_t val) {
+  host_pin_write(pin, val);
+}
+
+static inline int digitalRead(uint8_t pin) {
+  return host_pin_read(pin);
+}
+
+static inline void pinMatrixOutAttach(uint8_t pin, uint8_t function, bool invertOut, bool invertEnable) {
+}
+
+static inline void pinMatrixInAttach(uint8_t pin, uint8_t signal, bool inverted) {
+}
+
+static inline esp_err_t esp_intr_alloc(int source, int flags, void (*handler)(void*), void* arg, intr_handle_t* handle) {
+  return host_intr_alloc(source, handler, arg, handle);
+}
+
+static inline esp_err_t esp_intr_free(intr_handle_t handle) {
+  host_intr_free(handle);
+  return ESP_OK;
+}
+
+static inline void ets_install_putc1(void (*p)(char c)) {
+}
+
+static inline uint32_t ets_get_cpu_frequency(void) {
+  return HOST_CPU_MHZ;
+}
+
+static inline uint32_t getApbFrequency(void) {
+  return HOST_APB_FREQ;
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+  espArtNetRDM host model
+  The Arduino IPAddress class as espArtNetRDM.cpp uses it - 4 bytes in network order, read as a uint32_t
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <stdint.h>
+#include <string.h>
+
+#define INADDR_NONE ((uint32_t)0xffffffff)
+
+class IPAddress {
+  public:
+    IPAddress() {
+      _address.dword = 0;
+    }
+
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+      _address.bytes[0] = a;
+      _address.bytes[1] = b;
+      _address.bytes[2] = c;
+      _address.bytes[3] = d;
+    }
+
+    IPAddress(uint32_t address) {
+      _address.dword = address;
+    }
+
+    operator uint32_t() const {
+      return _address.dword;
+    }
+
+    bool operator==(const IPAddress& addr) const {
+      return _address.dword == addr._address.dword;
+    }
+
+    bool operator!=(const IPAddress& addr) const {
+      return _address.dword != addr._address.dword;
+    }
+
+    uint8_t operator[](int index) const {
+      return _address.bytes[index];
+    }
+
+    uint8_t& operator[](int index) {
+      return _address.bytes[index];
+    }
+
+  private:
+    union {
+      uint8_t bytes[4];
+      uint32_t dword;
+    } _address;
+};
+
+#endif
@@ -0,0 +1,32 @@
+/*
+  espArtNetRDM host model
+  The part of the Arduino String class espArtNetRDM.cpp uses
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef WString_h
+#define WString_h
+
+#include <string>
+
+class String {
+  public:
+    String(const char* c) : _s(c) {}
+
+    bool equals(const char* c) const {
+      return _s == c;
+    }
+
+  private:
+    std::string _s;
+};
+
+#endif
@@ -0,0 +1,22 @@
+/*
+  espArtNetRDM host model
+  espArtNetRDM.h only needs WiFiUDP & IPAddress from the WiFi library
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef WiFi_h
+#define WiFi_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiUdp.h"
+
+#endif
@@ -0,0 +1,128 @@
+/*
+  espArtNetRDM host model
+  WiFiUDP with a one packet inbox per port.  host_udp_deliver() queues a packet as if it came from ip,
+  the next parsePacket() on that port picks it up & anything written is counted then dropped
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#define HOST_UDP_PORTS  4
+
+struct host_udp_inbox {
+  uint16_t port;
+  IPAddress ip;
+  const uint8_t* data;      // Not copied - the caller keeps it until it's been read
+  uint16_t len;
+};
+
+// Inboxes shared by every WiFiUDP, one for each port in use
+static inline host_udp_inbox* host_udp_box(uint16_t port) {
+  static host_udp_inbox boxes[HOST_UDP_PORTS];
+
+  for (uint8_t x = 0; x < HOST_UDP_PORTS; x++) {
+    if (boxes[x].port == port || boxes[x].port == 0) {
+      boxes[x].port = port;
+      return &boxes[x];
+    }
+  }
+  return 0;
+}
+
+static inline void host_udp_deliver(uint16_t port, IPAddress ip, const uint8_t* data, uint16_t len) {
+  host_udp_inbox* box = host_udp_box(port);
+
+  if (box == 0)
+    return;
+
+  box->ip = ip;
+  box->data = data;
+  box->len = len;
+}
+
+// Packets the node has sent
+static inline uint32_t& host_udp_sent() {
+  static uint32_t sent = 0;
+  return sent;
+}
+
+class WiFiUDP {
+  public:
+    WiFiUDP() : _port(0), _data(0), _len(0), _pos(0) {}
+
+    uint8_t begin(uint16_t port) {
+      _port = port;
+      return 1;
+    }
+
+    void flush() {
+      _len = _pos = 0;
+    }
+
+    int parsePacket() {
+      host_udp_inbox* box = host_udp_box(_port);
+
+      _len = _pos = 0;
+      if (box == 0 || box->data == 0)
+        return 0;
+
+      _remote = box->ip;
+      _data = box->data;
+      _len = box->len;
+      box->data = 0;
+
+      return _len;
+    }
+
+    int read(unsigned char* buffer, size_t len) {
+      if (len > (size_t)(_len - _pos))
+        len = _len - _pos;
+
+      memcpy(buffer, &_data[_pos], len);
+      _pos += len;
+
+      return len;
+    }
+
+    size_t readBytes(uint8_t* buffer, size_t len) {
+      return read(buffer, len);
+    }
+
+    IPAddress remoteIP() {
+      return _remote;
+    }
+
+    int beginPacket(IPAddress ip, uint16_t port) {
+      return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t len) {
+      return len;
+    }
+
+    int endPacket() {
+      host_udp_sent()++;
+      return 1;
+    }
+
+  private:
+    uint16_t _port;
+    IPAddress _remote;
+    const uint8_t* _data;
+    uint16_t _len;
+    uint16_t _pos;
+};
+
+#endif
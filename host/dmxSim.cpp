@@ -0,0 +1,679 @@
+/*
+  espDMX host simulator
+  Runs espDMX_RDM.cpp unchanged against uartModel in simulated time, with RDM responders on each
+  port, & reports the refresh & RDM turnaround a configuration can get.
+
+  Build from this directory:
+    g++ -std=gnu++11 -O2 -DESPDMX_HOST -I. -I../ArtNetNode dmxSim.cpp uartModel.cpp \
+      ../ArtNetNode/espDMX_RDM.cpp ../ArtNetNode/rdmFIFO.cpp -o dmxSim
+
+  ./dmxSim [-p ports] [-t standard|turbo|safe] [-c chans] [-u updates/s] [-r responders]
+           [-g gets/s] [-d reply delay us] [-l loop us] [-i isr latency ns] [-m] [-n] [-s seconds]
+
+  -m sends port A from RMT channel 0 instead of its UART.  -n makes port A a DMX input, fed chans slots
+  at updates frames/s by a simulated console.  Everything runs in one thread & interrupts only run
+  between 1us steps, so the same arguments always give the same report.
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#include <stdio.h>
+#include <unistd.h>
+#include <deque>
+#include <vector>
+
+#include "Arduino.h"
+#include "espDMX_RDM.h"
+
+#define SIM_PORTS         3
+#define SIM_RDM_BREAK_NS  176000
+#define SIM_RDM_MAB_NS    12000
+#define SIM_SLOT_NS       44000
+#define SIM_MAX_REQ       260
+#define SIM_DMX_BREAK_NS  100000
+#define SIM_DMX_MAB_NS    12000
+
+static const char* sim_profile_names[DMX_TIMING_PROFILES] = { "standard", "turbo", "safe" };
+static const uint8_t sim_dir_pins[SIM_PORTS] = { 4, 5, 15 };
+
+struct sim_min_max {
+  uint64_t sum;
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+
+  void add(uint32_t v) {
+    if (count == 0 || v < min)
+      min = v;
+    if (v > max)
+      max = v;
+    sum += v;
+    count++;
+  }
+
+  double avg() const {
+    return count ? (double)sum / count : 0;
+  }
+};
+
+struct sim_responder {
+  uint16_t man;
+  uint32_t dev;
+  bool muted;
+};
+
+// A byte on its way to our RX pin.  c < 0 is a break
+struct sim_rx {
+  uint64_t at;
+  int16_t c;
+};
+
+struct sim_port {
+  espDMX* dmx;
+  uint8_t uart;
+  uint8_t dirPin;
+  bool input;
+
+  // What went out on the wire
+  uint64_t lastBreak;
+  bool afterMAB;
+  bool inFrame;
+  uint8_t startCode;
+  uint16_t slots;
+  uint32_t dmxFrames;
+  uint32_t rdmFrames;
+  sim_min_max breakNs;
+  sim_min_max mabNs;
+  sim_min_max periodNs;
+  sim_min_max frameSlots;
+
+  // RDM request being sent & the devices answering it
+  uint8_t req[SIM_MAX_REQ];
+  uint16_t reqLen;
+  uint64_t reqEnd;
+  bool listening;             // Direction pin went low after the request
+  bool released;
+  std::vector<sim_responder> responders;
+  std::deque<sim_rx> rx;
+  bool rxLost;
+  uint32_t replies;
+  uint32_t collisions;
+  sim_min_max releaseNs;      // Request end to our driver back on the line
+  sim_min_max nextBreakNs;    // Request end to the next break
+
+  uint32_t todReadyMs;
+  std::deque<uint64_t> gets;
+  uint32_t getsSent;
+  sim_min_max getNs;
+
+  // DMX input - frames the console sent & what the driver handed back
+  uint64_t consoleEnd;
+  uint32_t sentFrames;
+  uint32_t inFrames;
+  uint32_t badFrames;
+  sim_min_max inSlots;
+};
+
+static sim_port sim_ports[SIM_PORTS];
+static uint8_t sim_port_count = 1;
+static bool sim_rmt = false;
+static bool sim_input = false;
+
+static sim_port* sim_uart_port(uint8_t uart) {
+  for (uint8_t x = 0; x < sim_port_count; x++) {
+    if (sim_ports[x].uart == uart && !(sim_rmt && x == 0))
+      return &sim_ports[x];
+  }
+  return 0;
+}
+
+// Our transmitter only reaches the bus while the direction pin is high
+static bool sim_driving(sim_port* p) {
+  return !p->input && (p->dirPin == 255 || host_pin_read(p->dirPin) == HIGH);
+}
+
+static void sim_frame_start(sim_port* p, uint64_t breakStart) {
+  if (p->lastBreak != 0)
+    p->periodNs.add(breakStart - p->lastBreak);
+  p->lastBreak = breakStart;
+
+  if (p->inFrame && p->startCode == 0)
+    p->frameSlots.add(p->slots);
+  p->inFrame = false;
+}
+
+static void sim_tx_break(uint8_t uart, uint32_t ns) {
+  sim_port* p = sim_uart_port(uart);
+
+  if (p == 0)
+    return;
+
+  // Anything still answering our last request collides with this break
+  if (!p->rx.empty()) {
+    p->collisions++;
+    p->rx.clear();
+  }
+  if (p->reqEnd != 0) {
+    p->nextBreakNs.add(host_now_ns() - ns - p->reqEnd);
+    p->reqEnd = 0;
+  }
+
+  sim_frame_start(p, host_now_ns() - ns);
+  p->breakNs.add(ns);
+}
+
+static void sim_tx_mab(uint8_t uart, uint32_t ns) {
+  sim_port* p = sim_uart_port(uart);
+
+  if (p == 0)
+    return;
+
+  p->mabNs.add(ns);
+  p->afterMAB = true;
+}
+
+static void sim_reply_packet(sim_port* p, sim_responder* r, uint64_t at, uint16_t pid, uint8_t* pd, uint8_t pdl) {
+  uint8_t b[SIM_MAX_REQ];
+  uint8_t len = 24 + pdl;
+
+  b[0] = 0xCC;
+  b[1] = 0x01;
+  b[2] = len;
+  memcpy(&b[3], &p->req[9], 6);       // To whoever asked
+  b[9] = r->man >> 8;
+  b[10] = r->man;
+  b[11] = r->dev >> 24;
+  b[12] = r->dev >> 16;
+  b[13] = r->dev >> 8;
+  b[14] = r->dev;
+  b[15] = p->req[15];
+  b[16] = E120_RESPONSE_TYPE_ACK;
+  b[17] = 0;
+  b[18] = p->req[18];
+  b[19] = p->req[19];
+  b[20] = p->req[20] + 1;
+  b[21] = pid >> 8;
+  b[22] = pid;
+  b[23] = pdl;
+  memcpy(&b[24], pd, pdl);
+
+  uint16_t sum = 0;
+  for (uint8_t x = 0; x < len; x++)
+    sum += b[x];
+  b[len] = sum >> 8;
+  b[len + 1] = sum;
+
+  sim_rx c = { at + SIM_RDM_BREAK_NS, -1 };
+  p->rx.push_back(c);
+  at += SIM_RDM_BREAK_NS + SIM_RDM_MAB_NS;
+  for (uint16_t x = 0; x < len + 2; x++) {
+    at += SIM_SLOT_NS;
+    sim_rx d = { at, b[x] };
+    p->rx.push_back(d);
+  }
+}
+
+// Discovery replies have no break & every responder in the branch answers at once.  Two or more
+// come out as garbage - we AND them, as the bus would settle on something like it
+static void sim_reply_discovery(sim_port* p, uint64_t at, std::vector<sim_responder*>& found) {
+  uint8_t b[24];
+
+  memset(b, 0xFF, sizeof(b));
+  for (size_t n = 0; n < found.size(); n++) {
+    uint8_t uid[6] = { (uint8_t)(found[n]->man >> 8), (uint8_t)found[n]->man, (uint8_t)(found[n]->dev >> 24),
+                       (uint8_t)(found[n]->dev >> 16), (uint8_t)(found[n]->dev >> 8), (uint8_t)found[n]->dev };
+    uint8_t r[24];
+    uint16_t sum = 0;
+
+    memset(r, 0xFE, 7);
+    r[7] = 0xAA;
+    for (uint8_t x = 0; x < 6; x++) {
+      r[8 + x * 2] = uid[x] | 0xAA;
+      r[9 + x * 2] = uid[x] | 0x55;
+      sum += r[8 + x * 2] + r[9 + x * 2];
+    }
+    r[20] = (sum >> 8) | 0xAA;
+    r[21] = (sum >> 8) | 0x55;
+    r[22] = (sum & 0xFF) | 0xAA;
+    r[23] = (sum & 0xFF) | 0x55;
+
+    for (uint8_t x = 0; x < 24; x++)
+      b[x] &= r[x];
+  }
+
+  for (uint8_t x = 0; x < 24; x++) {
+    at += SIM_SLOT_NS;
+    sim_rx d = { at, b[x] };
+    p->rx.push_back(d);
+  }
+}
+
+static uint64_t sim_uid(uint8_t* b) {
+  uint64_t u = 0;
+
+  for (uint8_t x = 0; x < 6; x++)
+    u = (u << 8) | b[x];
+  return u;
+}
+
+// A whole request has gone out.  Answer it like E1.20 responders would
+static void sim_request(sim_port* p, uint64_t replyDelay) {
+  uint8_t len = p->req[2];
+  uint16_t sum = 0;
+
+  for (uint8_t x = 0; x < len; x++)
+    sum += p->req[x];
+  if (p->req[1] != 0x01 || p->req[len] != (sum >> 8) || p->req[len + 1] != (sum & 0xFF))
+    return;
+
+  uint64_t dest = sim_uid(&p->req[3]);
+  bool broadcast = (dest & 0xFFFFFFFFULL) == 0xFFFFFFFFULL;
+  uint8_t cc = p->req[20];
+  uint16_t pid = (p->req[21] << 8) | p->req[22];
+  uint64_t at = p->reqEnd + replyDelay;
+
+  if (cc == E120_DISCOVERY_COMMAND && pid == E120_DISC_UNIQUE_BRANCH) {
+    uint64_t lower = sim_uid(&p->req[24]);
+    uint64_t upper = sim_uid(&p->req[30]);
+    std::vector<sim_responder*> found;
+
+    for (size_t n = 0; n < p->responders.size(); n++) {
+      sim_responder* r = &p->responders[n];
+      uint64_t uid = ((uint64_t)r->man << 32) | r->dev;
+
+      if (!r->muted && uid >= lower && uid <= upper)
+        found.push_back(r);
+    }
+    if (!found.empty())
+      sim_reply_discovery(p, at, found);
+    return;
+  }
+
+  for (size_t n = 0; n < p->responders.size(); n++) {
+    sim_responder* r = &p->responders[n];
+    uint64_t uid = ((uint64_t)r->man << 32) | r->dev;
+
+    if (!broadcast && uid != dest)
+      continue;
+
+    if (cc == E120_DISCOVERY_COMMAND && (pid == E120_DISC_MUTE || pid == E120_DISC_UN_MUTE))
+      r->muted = (pid == E120_DISC_MUTE);
+
+    // Nothing answers a broadcast
+    if (!broadcast) {
+      uint8_t control[2] = { 0, 0 };
+      sim_reply_packet(p, r, at, pid, control, (cc == E120_DISCOVERY_COMMAND) ? 2 : 0);
+    }
+  }
+}
+
+static uint32_t sim_reply_delay;
+
+static void sim_tx_byte(uint8_t uart, uint8_t c) {
+  sim_port* p = sim_uart_port(uart);
+
+  if (p == 0 || !sim_driving(p))
+    return;
+
+  if (p->afterMAB) {
+    p->afterMAB = false;
+    p->startCode = c;
+    p->inFrame = true;
+    p->slots = 1;
+    p->reqLen = 0;
+
+    if (c == 0)
+      p->dmxFrames++;
+    else if (c == 0xCC)
+      p->rdmFrames++;
+  } else if (p->inFrame) {
+    p->slots++;
+  }
+
+  if (p->inFrame && p->startCode == 0xCC && p->reqLen < SIM_MAX_REQ) {
+    p->req[p->reqLen++] = c;
+
+    if (p->reqLen > 2 && p->reqLen == p->req[2] + 2) {
+      p->reqEnd = host_now_ns();
+      p->listening = false;
+      p->released = false;
+      sim_request(p, sim_reply_delay * 1000ULL);
+    }
+  }
+}
+
+static void sim_rmt_frame(uint8_t channel, const void* items, uint16_t n, uint32_t tickNs) {
+  const rmt_item32_t* item = (const rmt_item32_t*)items;
+  sim_port* p = &sim_ports[0];
+
+  sim_frame_start(p, host_now_ns());
+  p->breakNs.add(item[0].duration0 * tickNs);
+  p->mabNs.add(item[0].duration1 * tickNs);
+  p->dmxFrames++;
+  p->inFrame = true;
+  p->startCode = 0;
+  p->slots = 0;
+
+  // Decode the line the way a receiver would - expand the items after break & MAB into 4us bit cells,
+  // then take an 8N2 slot from each start bit, counting it only when both stop bits are marks
+  std::vector<uint8_t> cells;
+  for (uint16_t x = 1; x < n; x++) {
+    cells.insert(cells.end(), (item[x].duration0 + DMX_RMT_BIT_TICKS / 2) / DMX_RMT_BIT_TICKS, item[x].level0);
+    cells.insert(cells.end(), (item[x].duration1 + DMX_RMT_BIT_TICKS / 2) / DMX_RMT_BIT_TICKS, item[x].level1);
+  }
+
+  for (size_t c = 0; c + 11 <= cells.size(); ) {
+    // Marks between slots are idle line
+    if (cells[c] != 0) {
+      c++;
+      continue;
+    }
+
+    if (cells[c + 9] && cells[c + 10]) {
+      if (p->slots == 0) {
+        for (uint8_t b = 0; b < 8; b++)
+          p->startCode |= cells[c + 1 + b] << b;
+      }
+      p->slots++;
+    }
+    c += 11;
+  }
+}
+
+// Deliver whatever the responders have put on the bus by now
+static void sim_bus(sim_port* p) {
+  while (!p->rx.empty() && p->rx.front().at <= host_now_ns()) {
+    sim_rx c = p->rx.front();
+    p->rx.pop_front();
+
+    if (sim_driving(p)) {
+      if (!p->rxLost)
+        p->collisions++;
+      p->rxLost = true;
+      continue;
+    }
+    p->rxLost = false;
+
+    if (c.c < 0)
+      host_uart_rx_break(p->uart);
+    else
+      host_uart_rx(p->uart, c.c);
+
+    if (p->rx.empty() || p->rx.front().c < 0)
+      p->replies++;
+  }
+
+  // Back on the line once our driver has listened & turned the direction pin round again
+  if (p->reqEnd != 0 && !p->listening && !sim_driving(p))
+    p->listening = true;
+  if (p->reqEnd != 0 && p->listening && !p->released && sim_driving(p)) {
+    p->released = true;
+    p->releaseNs.add(host_now_ns() - p->reqEnd);
+  }
+}
+
+// A console on the other end of an input.  Slot x of each frame is the first slot + x, so the driver's
+// copy can be checked without knowing which frame it is
+static void sim_console_frame(sim_port* p, uint16_t chans, uint8_t level) {
+  uint64_t at = (p->consoleEnd > host_now_ns()) ? p->consoleEnd : host_now_ns();
+
+  // The UART flags a break a slot after the line goes low
+  sim_rx b = { at + SIM_SLOT_NS, -1 };
+  p->rx.push_back(b);
+  at += SIM_DMX_BREAK_NS + SIM_DMX_MAB_NS;
+
+  for (uint16_t x = 0; x <= chans; x++) {
+    at += SIM_SLOT_NS;
+    sim_rx d = { at, (int16_t)((x == 0) ? 0 : (uint8_t)(level + x - 1)) };
+    p->rx.push_back(d);
+  }
+
+  p->consoleEnd = at;
+  p->sentFrames++;
+}
+
+static void sim_input_frame(uint16_t numChans) {
+  sim_port* p = &sim_ports[0];
+  uint8_t* d = p->dmx->getChans();
+  bool good = true;
+
+  for (uint16_t x = 1; x < numChans && good; x++)
+    good = (d[x] == (uint8_t)(d[0] + x));
+
+  p->inFrames++;
+  p->inSlots.add(numChans);
+  if (!good)
+    p->badFrames++;
+}
+
+static void sim_rdm_reply(sim_port* p, rdm_data* c) {
+  if (p->gets.empty())
+    return;
+
+  p->getNs.add(host_now_ns() - p->gets.front());
+  p->gets.pop_front();
+}
+
+template <uint8_t N> static void sim_rdm_callback(rdm_data* c) {
+  sim_rdm_reply(&sim_ports[N], c);
+}
+
+static const rdmCallBackFunc sim_rdm_callbacks[SIM_PORTS] = {
+  sim_rdm_callback<0>, sim_rdm_callback<1>, sim_rdm_callback<2>
+};
+
+static void sim_usage(void) {
+  fprintf(stderr, "dmxSim [-p ports] [-t standard|turbo|safe] [-c chans] [-u updates/s] [-r responders]\n");
+  fprintf(stderr, "       [-g gets/s] [-d reply delay us] [-l loop us] [-i isr latency ns] [-m] [-n] [-s seconds]\n");
+}
+
+static void sim_report(sim_port* p, uint8_t x, double seconds) {
+  dmx_stats stats;
+  host_uart_stats uart;
+
+  p->dmx->getStats(&stats);
+  host_uart_get_stats(p->uart, &uart);
+
+  printf("Port %c (%s %u)\n", 'A' + x, (sim_rmt && x == 0) ? "RMT" : "UART", (sim_rmt && x == 0) ? 0 : p->uart);
+
+  if (p->input) {
+    printf("  DMX in %u frames sent, %u received, %u bad, %.1f slots/frame (%u-%u)\n", p->sentFrames, p->inFrames,
+           p->badFrames, p->inSlots.avg(), p->inSlots.min, p->inSlots.max);
+    printf("         driver saw %u frames, %u slots, break & MAB %uus (sent %.1fus), %u fps\n", stats.frames, stats.slots,
+           stats.breakUs, (SIM_DMX_BREAK_NS + SIM_DMX_MAB_NS) / 1000.0, stats.fps);
+    printf("         %u framing errors, %u short frames, %u other start codes\n", stats.frameErrors, stats.shortFrames,
+           stats.startCodes);
+    printf("  ISR    %u calls, %.1f/frame, %u storms, %u RX overflows\n", uart.isrCalls,
+           p->inFrames ? (double)uart.isrCalls / p->inFrames : 0.0, uart.isrStorms, uart.rxOverflow);
+    return;
+  }
+
+  printf("  DMX    %u frames, %.1f/s, %u keepalive, %.1f slots/frame\n", p->dmxFrames, p->dmxFrames / seconds,
+         stats.keepAlives, p->frameSlots.avg());
+  printf("         break %.1fus (%.1f-%.1f), MAB %.1fus (%.1f-%.1f)\n", p->breakNs.avg() / 1000, p->breakNs.min / 1000.0,
+         p->breakNs.max / 1000.0, p->mabNs.avg() / 1000, p->mabNs.min / 1000.0, p->mabNs.max / 1000.0);
+  printf("         break to break %.1fus (%.1f-%.1f)\n", p->periodNs.avg() / 1000, p->periodNs.min / 1000.0,
+         p->periodNs.max / 1000.0);
+  printf("         driver saw break %uus, MAB %uus, %u fps, latency %uus avg %uus max\n", stats.breakUs, stats.mabUs,
+         stats.fps, stats.latencyAvg, stats.latencyMax);
+
+  if (!(sim_rmt && x == 0))
+    printf("  ISR    %u calls, %.1f/frame, %u storms, %u TX overflows, %u RX overflows\n", uart.isrCalls,
+           (p->dmxFrames + p->rdmFrames) ? (double)uart.isrCalls / (p->dmxFrames + p->rdmFrames) : 0.0,
+           uart.isrStorms, uart.txOverflow, uart.rxOverflow);
+
+  if (p->responders.empty())
+    return;
+
+  printf("  RDM    %u requests, %u replies, %u collisions, %u preempted frames\n", p->rdmFrames, p->replies,
+         p->collisions, stats.rdmPreempted);
+  printf("         TOD %u of %u", p->dmx->todCount(), (unsigned)p->responders.size());
+  if (p->todReadyMs)
+    printf(" after %ums\n", p->todReadyMs);
+  else
+    printf(", not finished\n");
+  printf("         request end to line back %.1fus (%.1f-%.1f), to next break %.1fus\n", p->releaseNs.avg() / 1000,
+         p->releaseNs.min / 1000.0, p->releaseNs.max / 1000.0, p->nextBreakNs.avg() / 1000);
+  if (p->getsSent)
+    printf("         GET %u sent, %u answered, %.1fus round trip (max %.1f), %.1f transactions/s\n", p->getsSent,
+           p->getNs.count, p->getNs.avg() / 1000, p->getNs.max / 1000.0, p->getNs.count / seconds);
+}
+
+int main(int argc, char** argv) {
+  uint8_t profile = DMX_TIMING_STANDARD;
+  uint16_t chans = 512;
+  uint32_t updates = 44;
+  uint8_t responders = 0;
+  uint32_t getRate = 0;
+  uint32_t loopUs = 500;
+  uint32_t isrNs = 2000;
+  double seconds = 2;
+  int opt;
+
+  sim_reply_delay = 200;
+
+  while ((opt = getopt(argc, argv, "p:t:c:u:r:g:d:l:i:mns:h")) != -1) {
+    switch (opt) {
+      case 'p': sim_port_count = atoi(optarg); break;
+      case 't':
+        for (profile = 0; profile < DMX_TIMING_PROFILES; profile++) {
+          if (strcmp(optarg, sim_profile_names[profile]) == 0)
+            break;
+        }
+        break;
+      case 'c': chans = atoi(optarg); break;
+      case 'u': updates = atoi(optarg); break;
+      case 'r': responders = atoi(optarg); break;
+      case 'g': getRate = atoi(optarg); break;
+      case 'd': sim_reply_delay = atoi(optarg); break;
+      case 'l': loopUs = atoi(optarg); break;
+      case 'i': isrNs = atoi(optarg); break;
+      case 'm': sim_rmt = true; break;
+      case 'n': sim_input = true; break;
+      case 's': seconds = atof(optarg); break;
+      default:
+        sim_usage();
+        return 1;
+    }
+  }
+
+  if (sim_rmt && sim_input) {
+    sim_usage();
+    return 1;
+  }
+
+  if (sim_port_count < 1 || sim_port_count > SIM_PORTS || profile >= DMX_TIMING_PROFILES || chans < 1 || chans > 512 || loopUs == 0) {
+    sim_usage();
+    return 1;
+  }
+
+  espDMX* dmx[SIM_PORTS] = { &dmxA, &dmxB, &dmxC };
+  uint8_t data[512];
+
+  host_hook.txBreak = sim_tx_break;
+  host_hook.txMAB = sim_tx_mab;
+  host_hook.txByte = sim_tx_byte;
+  host_hook.rmtFrame = sim_rmt_frame;
+  host_set_isr_latency(isrNs);
+
+  for (uint8_t x = 0; x < sim_port_count; x++) {
+    sim_port* p = &sim_ports[x];
+    bool rdm = responders && !((sim_rmt || sim_input) && x == 0);
+
+    p->dmx = dmx[x];
+    p->uart = x;
+    p->input = sim_input && x == 0;
+    p->dirPin = rdm ? sim_dir_pins[x] : 255;
+
+    for (uint8_t r = 0; rdm && r < responders; r++) {
+      sim_responder d = { 0x4D54, 0x00100000U * (r + 1) + r * 0x1357, false };
+      p->responders.push_back(d);
+    }
+
+    if (sim_rmt && x == 0)
+      p->dmx->setRMT(0);
+    p->dmx->setTiming(profile);
+    p->dmx->begin(p->dirPin);
+
+    if (rdm) {
+      p->dmx->rdmEnable(0x7FF0, 0x00000001 + x);
+      p->dmx->rdmSetCallBack(sim_rdm_callbacks[x]);
+    }
+
+    if (p->input) {
+      p->dmx->dmxIn(true);
+      p->dmx->setInputCallback(sim_input_frame);
+    }
+  }
+
+  uint64_t end = seconds * 1000000000ULL;
+  uint64_t nextUpdate = 0;
+  uint64_t nextLoop = 0;
+  uint64_t nextGet = 0;
+  uint8_t level = 0;
+
+  while (host_now_ns() < end) {
+    host_step();
+
+    for (uint8_t x = 0; x < sim_port_count; x++)
+      sim_bus(&sim_ports[x]);
+
+    // New data from the network
+    if (updates && host_now_ns() >= nextUpdate) {
+      nextUpdate += 1000000000ULL / updates;
+      memset(data, ++level, chans);
+
+      for (uint8_t x = 0; x < sim_port_count; x++) {
+        if (sim_ports[x].input)
+          sim_console_frame(&sim_ports[x], chans, level);
+        else
+          sim_ports[x].dmx->setChans(data, chans, 1);
+      }
+    }
+
+    // loop()
+    if (host_now_ns() >= nextLoop) {
+      nextLoop += loopUs * 1000ULL;
+
+      for (uint8_t x = 0; x < sim_port_count; x++) {
+        sim_port* p = &sim_ports[x];
+
+        p->dmx->handler();
+
+        if (p->todReadyMs == 0 && !p->responders.empty() && p->dmx->todStatus() == RDM_TOD_READY)
+          p->todReadyMs = host_millis();
+      }
+    }
+
+    // GETs to the first device we found
+    if (getRate && host_now_ns() >= nextGet) {
+      nextGet += 1000000000ULL / getRate;
+
+      for (uint8_t x = 0; x < sim_port_count; x++) {
+        sim_port* p = &sim_ports[x];
+
+        if (p->responders.empty() || p->dmx->todCount() == 0)
+          continue;
+        if (p->dmx->rdmSendCommand(E120_GET_COMMAND, E120_DEVICE_INFO, p->dmx->todMan(0), p->dmx->todDev(0))) {
+          p->gets.push_back(host_now_ns());
+          p->getsSent++;
+        }
+      }
+    }
+  }
+
+  printf("%s timing, %u slots at %u updates/s, %u responders, loop %uus, ISR latency %uns, %.1fs\n",
+         sim_profile_names[profile], chans, updates, responders, loopUs, isrNs, seconds);
+
+  for (uint8_t x = 0; x < sim_port_count; x++)
+    sim_report(&sim_ports[x], x, seconds);
+
+  return 0;
+}
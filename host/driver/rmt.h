@@ -0,0 +1,93 @@
+/*
+  espDMX host model
+  The legacy RMT driver calls espDMX uses, timed by uartModel
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef rmt_h
+#define rmt_h
+
+#include "Arduino.h"
+
+typedef int gpio_num_t;
+
+typedef enum {
+  RMT_CHANNEL_0,
+  RMT_CHANNEL_1,
+  RMT_CHANNEL_2,
+  RMT_CHANNEL_3,
+  RMT_CHANNEL_4,
+  RMT_CHANNEL_5,
+  RMT_CHANNEL_6,
+  RMT_CHANNEL_7,
+  RMT_CHANNEL_MAX
+} rmt_channel_t;
+
+typedef enum {
+  RMT_MODE_TX,
+  RMT_MODE_RX
+} rmt_mode_t;
+
+typedef enum {
+  RMT_IDLE_LEVEL_LOW,
+  RMT_IDLE_LEVEL_HIGH
+} rmt_idle_level_t;
+
+typedef struct {
+  uint32_t duration0 : 15;
+  uint32_t level0 : 1;
+  uint32_t duration1 : 15;
+  uint32_t level1 : 1;
+} rmt_item32_t;
+
+typedef struct {
+  bool loop_en;
+  bool carrier_en;
+  bool idle_output_en;
+  rmt_idle_level_t idle_level;
+} rmt_tx_config_t;
+
+typedef struct {
+  rmt_mode_t rmt_mode;
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+  uint8_t mem_block_num;
+  rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+// Only the clock divider matters to the model
+extern uint8_t host_rmt_clk_div[RMT_CHANNEL_MAX];
+
+static inline esp_err_t rmt_config(const rmt_config_t* config) {
+  host_rmt_clk_div[config->channel] = config->clk_div;
+  return ESP_OK;
+}
+
+static inline esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rxBufSize, int intrFlags) {
+  return ESP_OK;
+}
+
+static inline esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+  return ESP_OK;
+}
+
+static inline esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t* items, int n, bool wait) {
+  host_rmt_write(channel, items, n, host_rmt_clk_div[channel]);
+  host_rmt_wait(channel, wait);
+  return ESP_OK;
+}
+
+static inline esp_err_t rmt_wait_tx_done(rmt_channel_t channel, uint32_t waitTicks) {
+  return host_rmt_wait(channel, waitTicks != 0) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*
+  espArtNetRDM host benchmark
+  Times the merge code in espArtNetRDM.cpp on the PC, for comparing one version against another: the HTP
+  merge on its own, then whole ArtDMX packets from 1, 2 & 4 sources through handler() & _saveDMX.  The
+  host has a wider, faster CPU than the ESP32, so only the ratios mean anything.
+
+  Build from this directory:
+    g++ -std=gnu++11 -O2 -DESPDMX_HOST -I. -I../ArtNetNode mergeBench.cpp uartModel.cpp -o mergeBench
+
+  ./mergeBench [-n runs]
+
+  Add -fno-tree-vectorize to the build to keep gcc from turning the merge loops into SSE, which is closer to
+  the Xtensa cores.  espArtNetRDM.cpp is included rather than linked so its static helpers can be timed.
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+
+#include "../ArtNetNode/espArtNetRDM.cpp"
+
+// Keeps the compiler from dropping or hoisting work whose result isn't otherwise used
+#define BENCH_USE(p)  asm volatile("" : : "r"(p) : "memory")
+
+#define BENCH_ROUNDS  5
+
+static uint32_t bench_runs = 200000;
+
+static double bench_ns(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / bench_runs;
+}
+
+static void bench_htp() {
+  // Word aligned like the source buffers in the arena
+  static uint32_t wa[DMX_BUFFER_SIZE / 4], wb[DMX_BUFFER_SIZE / 4], wd[DMX_BUFFER_SIZE / 4];
+  uint8_t* a = (uint8_t*)wa;
+  uint8_t* b = (uint8_t*)wb;
+  uint8_t* d = (uint8_t*)wd;
+
+  for (uint16_t x = 0; x < DMX_BUFFER_SIZE; x++) {
+    a[x] = (x * 37) & 0xFF;
+    b[x] = (x * 91 + 50) & 0xFF;
+  }
+
+  // Best of a few rounds, so another process taking the CPU doesn't count
+  double best = 0;
+  for (uint8_t round = 0; round < BENCH_ROUNDS; round++) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < bench_runs; r++) {
+      BENCH_USE(a);
+      artMergeHTP(d, a, b, DMX_BUFFER_SIZE);
+      BENCH_USE(d);
+    }
+    double ns = bench_ns(start);
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+
+  printf("HTP merge of %u slots\n", DMX_BUFFER_SIZE);
+  printf("  artMergeHTP  %8.1f ns\n", best);
+}
+
+static uint32_t bench_outputs = 0;
+
+static void bench_dmx(uint8_t g, uint8_t p, uint16_t n, bool sync) {
+  bench_outputs++;
+}
+
+// Artnet DMX from n sources in turn, each a full universe with one slot changing a packet, timed through
+// handler() as loop() runs it.  A handler() call with nothing waiting is timed too & taken off
+static void bench_packets(uint8_t sources) {
+  static uint8_t packets[ARTNET_MAX_SOURCES][ARTNET_ADDRESS_OFFSET + DMX_BUFFER_SIZE];
+  uint8_t mac[6] = { 0x02, 0, 0, 0, 0, 1 };
+
+  // init() copies the names at their full length
+  char shortName[ARTNET_SHORT_NAME_LENGTH] = "mergeBench";
+  char longName[ARTNET_LONG_NAME_LENGTH] = "mergeBench";
+
+  espArtNetRDM node;
+  node.init(IPAddress(2, 0, 0, 1), IPAddress(255, 0, 0, 0), false, shortName, longName, 0, 0, mac);
+  node.addGroup(0, 0);
+  node.addPort(0, 0, 0, DMX_OUT, MERGE_MODE_HTP);
+  node.setMaxSources(0, 0, sources);
+  node.setArtDMXCallback(bench_dmx);
+  node.begin();
+
+  for (uint8_t x = 0; x < sources; x++) {
+    uint8_t* c = packets[x];
+
+    memcpy(c, "Art-Net", 8);
+    c[8] = uint8_t(ARTNET_ARTDMX);
+    c[9] = uint8_t(ARTNET_ARTDMX >> 8);
+    c[10] = 0;
+    c[11] = 14;
+    c[12] = 0;
+    c[13] = 0;
+    c[14] = 0;
+    c[15] = 0;
+    c[16] = uint8_t(DMX_BUFFER_SIZE >> 8);
+    c[17] = uint8_t(DMX_BUFFER_SIZE);
+
+    for (uint16_t s = 0; s < DMX_BUFFER_SIZE; s++)
+      c[ARTNET_ADDRESS_OFFSET + s] = (s * 37 + x * 64) & 0xFF;
+  }
+
+  double idle = 0, packet = 0;
+  for (uint8_t round = 0; round < BENCH_ROUNDS; round++) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < bench_runs; r++)
+      node.handler();
+    double ns = bench_ns(start);
+    if (round == 0 || ns < idle)
+      idle = ns;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < bench_runs; r++) {
+      uint8_t x = r % sources;
+      packets[x][ARTNET_ADDRESS_OFFSET + (r / sources) % DMX_BUFFER_SIZE]++;
+
+      host_udp_deliver(ARTNET_PORT, IPAddress(10, 0, 0, 10 + x), packets[x], sizeof(packets[x]));
+      node.handler();
+    }
+    ns = bench_ns(start);
+    if (round == 0 || ns < packet)
+      packet = ns;
+  }
+
+  // Every source is still live, so the output is the HTP of all of them
+  uint8_t* out = node.getDMX(0, 0);
+  for (uint16_t s = 0; s < DMX_BUFFER_SIZE; s++) {
+    uint8_t v = 0;
+    for (uint8_t x = 0; x < sources; x++)
+      v = (packets[x][ARTNET_ADDRESS_OFFSET + s] > v) ? packets[x][ARTNET_ADDRESS_OFFSET + s] : v;
+
+    if (out[s] != v || bench_outputs == 0) {
+      printf("Output from %u sources isn't their HTP merge\n", sources);
+      exit(1);
+    }
+  }
+
+  printf("  %u source%s  %8.1f ns\n", sources, (sources == 1) ? " " : "s", packet - idle);
+}
+
+static void bench_usage() {
+  printf("mergeBench [-n runs]\n");
+}
+
+int main(int argc, char** argv) {
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:h")) != -1) {
+    switch (opt) {
+      case 'n': bench_runs = atoi(optarg); break;
+      default:
+        bench_usage();
+        return 1;
+    }
+  }
+
+  if (bench_runs == 0) {
+    bench_usage();
+    return 1;
+  }
+
+  bench_htp();
+
+  printf("Artnet DMX packet, %u slots, HTP\n", DMX_BUFFER_SIZE);
+  bench_packets(1);
+  bench_packets(2);
+  bench_packets(4);
+
+  return 0;
+}
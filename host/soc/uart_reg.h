@@ -0,0 +1,24 @@
+/*
+  espDMX host model
+  UART base addresses point at the model's registers
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef uart_reg_h
+#define uart_reg_h
+
+#include "uartModel.h"
+
+#define DR_REG_UART_BASE  (&host_uart[0])
+#define DR_REG_UART1_BASE (&host_uart[1])
+#define DR_REG_UART2_BASE (&host_uart[2])
+
+#endif
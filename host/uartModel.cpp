@@ -0,0 +1,444 @@
+/*
+  espDMX host model
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#include "uartModel.h"
+
+#include <string.h>
+#include <deque>
+
+#include "driver/rmt.h"
+
+#define HOST_STEP_NS    1000
+#define HOST_ISR_REPEAT 16    // Calls in one step before we call it an interrupt storm
+#define HOST_POLL_READS 64    // Status reads in one step before a busy-wait moves time on
+
+// The driver only ever sees these through uart_dev_array
+host_uart_regs host_uart[HOST_UARTS];
+host_hooks host_hook;
+uint8_t host_rmt_clk_div[RMT_CHANNEL_MAX];
+
+enum host_tx_phase {
+  TX_IDLE,
+  TX_DATA,
+  TX_BREAK,
+  TX_MAB
+};
+
+struct host_uart_model {
+  uint32_t reg[sizeof(host_uart_regs)];   // Plain fields, by offset
+  std::deque<uint8_t> txfifo;
+  std::deque<uint8_t> rxfifo;
+  uint32_t raw;                 // Latched interrupt bits.  FIFO thresholds are levels - see host_int_level()
+  uint32_t ena;
+  bool brkReq;                  // txd_brk went high & the break hasn't started
+  host_tx_phase phase;
+  uint64_t phaseEnd;
+  uint64_t phaseStart;
+  uint8_t txByte;
+  uint64_t rxLast;              // When the last byte arrived, for the RX timeout
+  bool rxToutArmed;
+
+  void (*isr)(void*);
+  void* isrArg;
+  uint64_t isrDue;
+  bool isrPending;
+  host_uart_stats stats;
+};
+
+struct host_rmt_model {
+  uint64_t busyUntil;
+};
+
+static host_uart_model host_model[HOST_UARTS];
+static host_rmt_model host_rmt[HOST_RMT_CHANNELS];
+static uint8_t host_pins[HOST_PINS];
+static uint64_t host_time = 0;
+static uint32_t host_isr_latency = 0;
+static uint32_t host_poll_reads = 0;
+static bool host_in_isr = false;
+
+#define HOST_OFF(f)   offsetof(host_uart_regs, f)
+
+static const uint32_t host_int_bits[] = {
+  HOST_INT_RXFIFO_FULL, HOST_INT_TXFIFO_EMPTY, 1 << 2, HOST_INT_FRM_ERR, HOST_INT_RXFIFO_OVF,
+  HOST_INT_BRK_DET, HOST_INT_RXFIFO_TOUT, HOST_INT_TX_BRK_DONE, HOST_INT_TX_BRK_IDLE_DONE, HOST_INT_TX_DONE
+};
+
+// Which interrupt bit a field of an int_* register is - 0 for val
+static uint32_t host_int_bit(size_t off, size_t base) {
+  size_t n = (off - base) / sizeof(host_field);
+
+  return (n < sizeof(host_int_bits) / sizeof(host_int_bits[0])) ? host_int_bits[n] : 0;
+}
+
+static bool host_field_in(size_t off, size_t base, size_t size = sizeof(host_int_reg)) {
+  return off >= base && off < base + size;
+}
+
+// The driver relies on a TX threshold of 0 firing on an empty FIFO, so both are inclusive
+static uint32_t host_int_level(host_uart_model* u) {
+  uint32_t level = 0;
+
+  if (u->txfifo.size() <= u->reg[HOST_OFF(conf1.txfifo_empty_thrhd)])
+    level |= HOST_INT_TXFIFO_EMPTY;
+  if (u->rxfifo.size() > 0 && u->rxfifo.size() >= u->reg[HOST_OFF(conf1.rxfifo_full_thrhd)])
+    level |= HOST_INT_RXFIFO_FULL;
+
+  return level;
+}
+
+static uint32_t host_int_status(host_uart_model* u) {
+  return (u->raw | host_int_level(u)) & u->ena;
+}
+
+static uint64_t host_bit_ns(host_uart_model* u) {
+  uint64_t div = (u->reg[HOST_OFF(clk_div.div_int)] << 4) | u->reg[HOST_OFF(clk_div.div_frag)];
+
+  if (div == 0)
+    return 4000;
+  return div * 1000000000ULL / ((uint64_t)HOST_APB_FREQ << 4);
+}
+
+static void host_uart_tick(uint8_t n);
+
+// Busy-waits on the status register from task code need time to move or they never end
+static void host_poll(void) {
+  if (host_in_isr || ++host_poll_reads < HOST_POLL_READS)
+    return;
+
+  host_poll_reads = 0;
+  host_time += HOST_STEP_NS;
+  for (uint8_t n = 0; n < HOST_UARTS; n++)
+    host_uart_tick(n);
+}
+
+static uint32_t host_uart_read(uint8_t n, size_t off) {
+  host_uart_model* u = &host_model[n];
+
+  if (off == HOST_OFF(fifo.rw_byte)) {
+    if (u->rxfifo.empty())
+      return 0;
+    uint8_t c = u->rxfifo.front();
+    u->rxfifo.pop_front();
+    return c;
+  }
+
+  if (host_field_in(off, HOST_OFF(int_raw)) || host_field_in(off, HOST_OFF(int_st))) {
+    uint32_t bits = host_field_in(off, HOST_OFF(int_raw)) ? (u->raw | host_int_level(u)) : host_int_status(u);
+    uint32_t bit = host_int_bit(off, host_field_in(off, HOST_OFF(int_raw)) ? HOST_OFF(int_raw) : HOST_OFF(int_st));
+
+    return (bit == 0) ? bits : ((bits & bit) ? 1 : 0);
+  }
+
+  if (host_field_in(off, HOST_OFF(int_ena))) {
+    uint32_t bit = host_int_bit(off, HOST_OFF(int_ena));
+    return (bit == 0) ? u->ena : ((u->ena & bit) ? 1 : 0);
+  }
+
+  switch (off) {
+    case HOST_OFF(status.txfifo_cnt):
+      host_poll();
+      return u->txfifo.size();
+    case HOST_OFF(status.st_utx_out):
+      host_poll();
+      return (u->phase == TX_IDLE) ? 0 : 1;
+    case HOST_OFF(status.rxfifo_cnt):
+      return u->rxfifo.size();
+    case HOST_OFF(status.st_urx_out):
+    case HOST_OFF(mem_rx_status.rd_addr):
+    case HOST_OFF(mem_rx_status.wr_addr):
+      return 0;
+  }
+
+  return u->reg[off];
+}
+
+static void host_uart_write(uint8_t n, size_t off, uint32_t v) {
+  host_uart_model* u = &host_model[n];
+
+  if (off == HOST_OFF(fifo.rw_byte)) {
+    if (u->txfifo.size() >= HOST_FIFO_SIZE)
+      u->stats.txOverflow++;
+    else
+      u->txfifo.push_back(v);
+    return;
+  }
+
+  // Write 1 to clear.  FIFO threshold levels come straight back if they still hold
+  if (host_field_in(off, HOST_OFF(int_clr))) {
+    uint32_t bit = host_int_bit(off, HOST_OFF(int_clr));
+    if (bit == 0)
+      u->raw &= ~v;
+    else if (v)
+      u->raw &= ~bit;
+    return;
+  }
+
+  if (host_field_in(off, HOST_OFF(int_ena))) {
+    uint32_t bit = host_int_bit(off, HOST_OFF(int_ena));
+    if (bit == 0)
+      u->ena = v;
+    else if (v)
+      u->ena |= bit;
+    else
+      u->ena &= ~bit;
+    return;
+  }
+
+  // Only int_raw & the counts are read only, the rest are plain fields
+  if (host_field_in(off, HOST_OFF(int_raw)) || host_field_in(off, HOST_OFF(int_st)) || host_field_in(off, HOST_OFF(status), sizeof(host_uart_regs::status)))
+    return;
+
+  switch (off) {
+    case HOST_OFF(conf0.txd_brk):
+      if (v && !u->reg[off])
+        u->brkReq = true;
+      else if (!v)
+        u->brkReq = false;
+      break;
+    case HOST_OFF(conf0.txfifo_rst):
+      if (v)
+        u->txfifo.clear();
+      break;
+    case HOST_OFF(conf0.rxfifo_rst):
+      if (v)
+        u->rxfifo.clear();
+      break;
+  }
+
+  u->reg[off] = v;
+}
+
+static void host_locate(const volatile host_field* f, uint8_t* n, size_t* off) {
+  size_t a = (const volatile char*)f - (const volatile char*)host_uart;
+
+  *n = a / sizeof(host_uart_regs);
+  *off = a % sizeof(host_uart_regs);
+}
+
+host_field::operator uint32_t() const volatile {
+  uint8_t n;
+  size_t off;
+
+  host_locate(this, &n, &off);
+  return host_uart_read(n, off);
+}
+
+void host_field::operator=(uint32_t v) volatile {
+  uint8_t n;
+  size_t off;
+
+  host_locate(this, &n, &off);
+  host_uart_write(n, off, v);
+}
+
+// Shift out whatever is next.  Data in the FIFO goes before a break, & the FIFO waits for the MAB
+static void host_uart_tick(uint8_t n) {
+  host_uart_model* u = &host_model[n];
+  uint64_t bit = host_bit_ns(u);
+
+  // RX timeout - the line has been idle for rx_tout_thrhd byte times with data still in the FIFO
+  if (u->rxToutArmed && u->reg[HOST_OFF(conf1.rx_tout_en)] && !u->rxfifo.empty() &&
+      host_time - u->rxLast >= u->reg[HOST_OFF(conf1.rx_tout_thrhd)] * 11 * bit) {
+    u->rxToutArmed = false;
+    u->raw |= HOST_INT_RXFIFO_TOUT;
+  }
+
+  if (u->phase != TX_IDLE && host_time >= u->phaseEnd) {
+    switch (u->phase) {
+      case TX_DATA:
+        if (host_hook.txByte)
+          host_hook.txByte(n, u->txByte);
+        if (u->txfifo.empty())
+          u->raw |= HOST_INT_TX_DONE;
+        u->phase = TX_IDLE;
+        break;
+
+      case TX_BREAK:
+        u->raw |= HOST_INT_TX_BRK_DONE;
+        if (host_hook.txBreak)
+          host_hook.txBreak(n, u->phaseEnd - u->phaseStart);
+        u->phase = TX_MAB;
+        u->phaseStart = u->phaseEnd;
+        u->phaseEnd += u->reg[HOST_OFF(idle_conf.tx_idle_num)] * bit;
+        return;
+
+      case TX_MAB:
+        u->raw |= HOST_INT_TX_BRK_IDLE_DONE;
+        if (host_hook.txMAB)
+          host_hook.txMAB(n, u->phaseEnd - u->phaseStart);
+        u->phase = TX_IDLE;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (u->phase != TX_IDLE)
+    return;
+
+  uint64_t start = (u->phaseEnd > host_time - HOST_STEP_NS) ? u->phaseEnd : host_time;
+
+  if (!u->txfifo.empty()) {
+    // Start bit, 8 data bits & 2 stop bits, with dl1_en delaying the stop bits a bit more
+    u->txByte = u->txfifo.front();
+    u->txfifo.pop_front();
+    u->phase = TX_DATA;
+    u->phaseStart = start;
+    u->phaseEnd = start + (11 + (u->reg[HOST_OFF(rs485_conf.dl1_en)] ? 1 : 0)) * bit;
+
+  } else if (u->brkReq) {
+    u->brkReq = false;
+    u->phase = TX_BREAK;
+    u->phaseStart = start;
+    u->phaseEnd = start + u->reg[HOST_OFF(idle_conf.tx_brk_num)] * bit;
+  }
+}
+
+static void host_uart_isr(uint8_t n) {
+  host_uart_model* u = &host_model[n];
+
+  if (u->isr == 0)
+    return;
+
+  for (uint8_t x = 0; host_int_status(u) != 0; x++) {
+    if (!u->isrPending) {
+      u->isrPending = true;
+      u->isrDue = host_time + host_isr_latency;
+    }
+    if (host_time < u->isrDue)
+      return;
+
+    if (x == HOST_ISR_REPEAT) {
+      u->stats.isrStorms++;
+      return;
+    }
+
+    u->isrPending = false;
+    u->stats.isrCalls++;
+    host_in_isr = true;
+    u->isr(u->isrArg);
+    host_in_isr = false;
+  }
+  u->isrPending = false;
+}
+
+uint64_t host_now_ns(void) {
+  return host_time;
+}
+
+uint32_t host_micros(void) {
+  return host_time / 1000;
+}
+
+uint32_t host_millis(void) {
+  return host_time / 1000000;
+}
+
+uint32_t host_ccount(void) {
+  return host_time * HOST_CPU_MHZ / 1000;
+}
+
+void host_set_isr_latency(uint32_t ns) {
+  host_isr_latency = ns;
+}
+
+void host_step(void) {
+  host_time += HOST_STEP_NS;
+  host_poll_reads = 0;
+
+  for (uint8_t n = 0; n < HOST_UARTS; n++)
+    host_uart_tick(n);
+  for (uint8_t n = 0; n < HOST_UARTS; n++)
+    host_uart_isr(n);
+}
+
+void host_pin_write(uint8_t pin, uint8_t level) {
+  host_pins[pin] = level;
+}
+
+uint8_t host_pin_read(uint8_t pin) {
+  return host_pins[pin];
+}
+
+// UART sources only - the argument is all we need
+int host_intr_alloc(int source, void (*handler)(void*), void* arg, void** handle) {
+  uint8_t n = source - ETS_UART0_INTR_SOURCE;
+
+  if (n >= HOST_UARTS)
+    return -1;
+
+  host_model[n].isr = handler;
+  host_model[n].isrArg = arg;
+  host_model[n].isrPending = false;
+  *handle = &host_model[n];
+  return 0;
+}
+
+void host_intr_free(void* handle) {
+  host_uart_model* u = (host_uart_model*)handle;
+
+  u->isr = 0;
+  u->isrArg = 0;
+}
+
+void host_rmt_write(uint8_t channel, const void* items, uint16_t n, uint16_t clkDiv) {
+  const rmt_item32_t* item = (const rmt_item32_t*)items;
+  uint32_t tickNs = clkDiv * 1000000000ULL / HOST_APB_FREQ;
+  uint64_t ticks = 0;
+
+  for (uint16_t x = 0; x < n; x++)
+    ticks += item[x].duration0 + item[x].duration1;
+
+  host_rmt[channel].busyUntil = host_time + ticks * tickNs;
+
+  if (host_hook.rmtFrame)
+    host_hook.rmtFrame(channel, items, n, tickNs);
+}
+
+bool host_rmt_wait(uint8_t channel, bool block) {
+  while (block && host_time < host_rmt[channel].busyUntil)
+    host_step();
+
+  return host_time >= host_rmt[channel].busyUntil;
+}
+
+void host_uart_rx(uint8_t uart, uint8_t c) {
+  host_uart_model* u = &host_model[uart];
+
+  if (u->rxfifo.size() >= HOST_FIFO_SIZE) {
+    u->raw |= HOST_INT_RXFIFO_OVF;
+    u->stats.rxOverflow++;
+    return;
+  }
+
+  u->rxfifo.push_back(c);
+  u->stats.rxBytes++;
+  u->rxLast = host_time;
+  u->rxToutArmed = true;
+}
+
+// The UART sees a break as a null byte with a framing error, then flags the break
+void host_uart_rx_break(uint8_t uart) {
+  host_uart_rx(uart, 0);
+  host_model[uart].raw |= HOST_INT_BRK_DET;
+}
+
+bool host_uart_tx_idle(uint8_t uart) {
+  return host_model[uart].phase == TX_IDLE && host_model[uart].txfifo.empty();
+}
+
+void host_uart_get_stats(uint8_t uart, host_uart_stats* stats) {
+  *stats = host_model[uart].stats;
+}
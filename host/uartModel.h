@@ -0,0 +1,155 @@
+/*
+  espDMX host model
+  Register level model of the ESP32 UARTs, RMT, GPIO & interrupts in simulated time so espDMX_RDM.cpp
+  can run unchanged on a PC.  See dmxSim.cpp.
+
+  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with this program.
+  If not, see http://www.gnu.org/licenses/
+*/
+#ifndef uartModel_h
+#define uartModel_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HOST_UARTS        3
+#define HOST_RMT_CHANNELS 8
+#define HOST_PINS         256
+#define HOST_FIFO_SIZE    128
+#define HOST_CPU_MHZ      240
+#define HOST_APB_FREQ     80000000
+
+// Interrupt bits, as laid out in the UART's int_raw/int_st/int_ena/int_clr registers
+#define HOST_INT_RXFIFO_FULL      (1 << 0)
+#define HOST_INT_TXFIFO_EMPTY     (1 << 1)
+#define HOST_INT_FRM_ERR          (1 << 3)
+#define HOST_INT_RXFIFO_OVF       (1 << 4)
+#define HOST_INT_BRK_DET          (1 << 7)
+#define HOST_INT_RXFIFO_TOUT      (1 << 8)
+#define HOST_INT_TX_BRK_DONE      (1 << 12)
+#define HOST_INT_TX_BRK_IDLE_DONE (1 << 13)
+#define HOST_INT_TX_DONE          (1 << 14)
+
+// One register field.  Reads & writes go to the model, which works out which UART & field from
+// the address - so registers behave like the hardware's (FIFO pops, write-1-to-clear & so on)
+struct host_field {
+  uint8_t pad;
+
+  operator uint32_t() const volatile;
+  void operator=(uint32_t v) volatile;
+};
+
+struct host_int_reg {
+  host_field rxfifo_full;
+  host_field txfifo_empty;
+  host_field parity_err;
+  host_field frm_err;
+  host_field rxfifo_ovf;
+  host_field brk_det;
+  host_field rxfifo_tout;
+  host_field tx_brk_done;
+  host_field tx_brk_idle_done;
+  host_field tx_done;
+  host_field val;
+};
+
+// The parts of uart_dev_t that espDMX uses
+struct host_uart_regs {
+  struct {
+    host_field rw_byte;
+  } fifo;
+  host_int_reg int_raw;
+  host_int_reg int_st;
+  host_int_reg int_ena;
+  host_int_reg int_clr;
+  struct {
+    host_field div_int;
+    host_field div_frag;
+  } clk_div;
+  struct {
+    host_field rxfifo_cnt;
+    host_field st_urx_out;
+    host_field txfifo_cnt;
+    host_field st_utx_out;
+  } status;
+  struct {
+    host_field parity;
+    host_field parity_en;
+    host_field bit_num;
+    host_field stop_bit_num;
+    host_field txd_brk;
+    host_field rxfifo_rst;
+    host_field txfifo_rst;
+  } conf0;
+  struct {
+    host_field rxfifo_full_thrhd;
+    host_field txfifo_empty_thrhd;
+    host_field rx_tout_thrhd;
+    host_field rx_tout_en;
+  } conf1;
+  struct {
+    host_field rx_idle_thrhd;
+    host_field tx_idle_num;
+    host_field tx_brk_num;
+  } idle_conf;
+  struct {
+    host_field en;
+    host_field dl0_en;
+    host_field dl1_en;
+  } rs485_conf;
+  struct {
+    host_field rd_addr;
+    host_field wr_addr;
+  } mem_rx_status;
+};
+
+extern host_uart_regs host_uart[HOST_UARTS];
+
+// What the model saw on each UART's TX line & RMT channel - set by the simulator
+struct host_hooks {
+  void (*txBreak)(uint8_t uart, uint32_t breakNs);
+  void (*txMAB)(uint8_t uart, uint32_t mabNs);
+  void (*txByte)(uint8_t uart, uint8_t c);
+  void (*rmtFrame)(uint8_t channel, const void* items, uint16_t n, uint32_t tickNs);
+};
+
+struct host_uart_stats {
+  uint32_t isrCalls;
+  uint32_t isrStorms;     // Still pending after 16 calls in a row
+  uint32_t txOverflow;    // Writes to a full TX FIFO
+  uint32_t rxOverflow;
+  uint32_t rxBytes;
+};
+
+extern host_hooks host_hook;
+
+// Simulated time.  host_step() moves on 1us, ticks the UARTs & RMT then runs any pending interrupts
+uint64_t host_now_ns(void);
+uint32_t host_micros(void);
+uint32_t host_millis(void);
+uint32_t host_ccount(void);
+void host_step(void);
+void host_set_isr_latency(uint32_t ns);
+
+// GPIO, interrupts & RMT as seen by the driver
+void host_pin_write(uint8_t pin, uint8_t level);
+uint8_t host_pin_read(uint8_t pin);
+int host_intr_alloc(int source, void (*handler)(void*), void* arg, void** handle);
+void host_intr_free(void* handle);
+void host_rmt_write(uint8_t channel, const void* items, uint16_t n, uint16_t clkDiv);
+bool host_rmt_wait(uint8_t channel, bool block);
+
+// The bus side of each UART's RX - responders call these as their bytes arrive
+void host_uart_rx(uint8_t uart, uint8_t c);
+void host_uart_rx_break(uint8_t uart);
+bool host_uart_tx_idle(uint8_t uart);
+void host_uart_get_stats(uint8_t uart, host_uart_stats* stats);
+
+#endif